@@ -1,26 +1,215 @@
 #include "analysis.hpp"
 
 #include "config.hpp"
+#include "edge_probs.hpp"
 #include "generate.hpp"
 #include "graph.hpp"
+#include "parallel.hpp"
 #include "poisson.hpp"
 #include "polynomial.hpp"
 #include "serializer.hpp"
 #include "utils.hpp"
 #include "utils_ana.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 #include <boost/foreach.hpp>
-#include <boost/progress.hpp>
 
-boost::tuple<pp_matrix, pt_matrix>
-ana_iteration(const Graph &g, const fp_matrix &tm,
-              int HL, const list<pt_matrix> &ptm_list,
+/**
+ * Traces the packets of a destination node.  The rows of the
+ * destinations are kept apart, so that the destinations can be
+ * processed concurrently.
+ */
+class destination_task
+{
+  const Graph &g;
+  int HL;
+  const fp_matrix &atm;
+  const edge_probs_matrix &epm;
+  parallel_progress &progress;
+
+  /// The destinations to trace, the others are taken from history.
+  const vector<bool> &changed;
+
+  /// The results of the previous iteration, or null if there are none.
+  ana_history *history;
+
+public:
+  /// The rows of the packet presence matrix of the destinations.
+  vector<pp_matrix::mapped_type> ppms;
+
+  /// The rows of the packet trajectory matrix of the destinations.
+  vector<pt_matrix::mapped_type> ptms;
+
+  destination_task(const Graph &g, int HL, const fp_matrix &atm,
+                   const edge_probs_matrix &epm,
+                   parallel_progress &progress,
+                   const vector<bool> &changed,
+                   ana_history *history) :
+    g(g), HL(HL), atm(atm), epm(epm), progress(progress),
+    changed(changed), history(history),
+    ppms(num_vertices(g)), ptms(num_vertices(g))
+  {
+  }
+
+  /// Processes destination node i.
+  void operator()(int i)
+  {
+    pp_matrix::mapped_type &ppr = ppms[i];
+    pt_matrix::mapped_type &ptr = ptms[i];
+
+    // The results of an unchanged destination are the same as in the
+    // previous iteration, and so we take them from the history.  The
+    // history is replaced with the results of this iteration anyway.
+    if (!changed[i])
+      {
+        assert(history);
+
+        pp_matrix::iterator ppi = history->ppm.find(i);
+        if (ppi != history->ppm.end())
+          ppr.swap(ppi->second);
+
+        pt_matrix::iterator pti = history->ptm.find(i);
+        if (pti != history->ptm.end())
+          ptr.swap(pti->second);
+
+        return;
+      }
+
+    // This is the transition matrix.  This matrix is shared among
+    // all packets that have the same destination node.  Once
+    // generated, we freeze it to make the hops faster.
+    csr_trans_matrix T;
+    {
+      trans_matrix t;
+      generate_T(g, i, epm, t);
+      T = csr_trans_matrix(t);
+    }
+
+    // For every source node j.
+    BGL_FORALL_VERTICES(j, g, Graph)
+      if (i != j && atm.exists(i, j))
+        {
+          double admitted = atm.at(i, j);
+          assert(admitted != 0);
+
+          // Packet presence vector, indexed with the nodes.
+          vector<dist_poly> P(num_vertices(g));
+          // Here we remember the admission probability.
+          P[j] = dist_poly(distro(poisson(admitted)));
+          ppr[j][0][j] = P[j];
+
+          // In this loop we trace all the hops of a packet.
+          for(int hop = 1; hop <= HL; ++hop)
+            {
+              // Each loop iteration corresponds to the packet
+              // traversing some links, because it makes one hop.
+              // For every link we want to know the polynomial that
+              // describes the traversing packets.
+              vector<dist_poly> nodes(num_vertices(g));
+              map<Edge, dist_poly> links;
+
+              make_hop(g, P, T, nodes, links);
+
+              // Only the nodes with packets make it to the matrix.
+              map<Vertex, dist_poly> &ppn = ppr[j][hop];
+              BGL_FORALL_VERTICES(v, g, Graph)
+                if (!nodes[v].empty())
+                  ppn[v] = nodes[v];
+
+              ptr[j][hop].swap(links);
+              P.swap(nodes);
+
+              ++progress;
+            }
+        }
+  }
+};
+
+/**
+ * The change of an admission rate.
+ */
+static double
+diff(double a, double b)
+{
+  return fabs(a - b);
+}
+
+/**
+ * The change of the edge probabilities.
+ */
+static double
+diff(const edge_probs &a, const edge_probs &b)
+{
+  return max_diff(a, b);
+}
+
+/**
+ * Takes from the matrix prev the elements of the matrix curr that
+ * changed by less than the tolerance, so that they are exactly the
+ * same.  The rows of the destinations with some other changes are
+ * marked in changed.
+ */
+template<typename T>
+static void
+reuse(const Graph &g, double tolerance, const sparse_matrix<Vertex, T> &prev,
+      sparse_matrix<Vertex, T> &curr, vector<bool> &changed)
+{
+  typedef map<Vertex, T> row_type;
+  static const row_type empty;
+
+  BGL_FORALL_VERTICES(i, g, Graph)
+    {
+      typename sparse_matrix<Vertex, T>::const_iterator
+        pi = prev.find(i);
+      typename sparse_matrix<Vertex, T>::iterator ci = curr.find(i);
+
+      const row_type &pr = pi == prev.end() ? empty : pi->second;
+
+      // The row is gone.
+      if (ci == curr.end())
+        {
+          if (!pr.empty())
+            changed[i] = true;
+          continue;
+        }
+
+      row_type &cr = ci->second;
+
+      // The elements that are gone.
+      for(typename row_type::const_iterator
+            j = pr.begin(); j != pr.end(); ++j)
+        if (cr.find(j->first) == cr.end())
+          changed[i] = true;
+
+      for(typename row_type::iterator j = cr.begin(); j != cr.end(); ++j)
+        {
+          typename row_type::const_iterator p = pr.find(j->first);
+
+          if (p != pr.end() && diff(p->second, j->second) < tolerance)
+            j->second = p->second;
+          else
+            changed[i] = true;
+        }
+    }
+}
+
+/**
+ * The iteration, which is incremental if the history is given.  The
+ * results are put into ppm and ptm, which should be empty.
+ */
+static void
+ana_iteration(const Graph &g, int HL, int threads,
+              const list<ana_rates> &rates_list,
+              vector<route_cache> &caches, double tolerance,
+              ana_history *history, pp_matrix &ppm, pt_matrix &ptm,
               ostream &os)
 {
-  // This is the matrix of input traffic.
-  fp_matrix itm;
+  assert(threads >= 1);
+  assert(ppm.empty() && ptm.empty());
 
   // This is the admitted traffic matrix.
   fp_matrix atm;
@@ -28,122 +217,254 @@ ana_iteration(const Graph &g, const fp_matrix &tm,
   // This is the matrix of output demands.
   fp_matrix otm;
 
-  os << "Generating ITM, ATM and OTM" << endl;
+  os << "Averaging ATM and OTM" << endl;
 
-  BOOST_FOREACH(const pt_matrix &ptm, ptm_list)
+  BOOST_FOREACH(const ana_rates &rates, rates_list)
     {
-      // These are the matrices for a single iteration.
-      fp_matrix pitm;
-      fp_matrix patm;
-      fp_matrix potm;
-
-      generate_itm(g, ptm, pitm);
-      generate_atm(g, tm, pitm, patm);
-      generate_otm(pitm, patm, potm);
-
-      atm = atm + patm;
-      otm = otm + potm;
+      atm = atm + rates.atm;
+      otm = otm + rates.otm;
     }
 
-  float weight = 1.0 / ptm_list.size();
+  float weight = 1.0 / rates_list.size();
   atm = weight * atm;
   otm = weight * otm;
 
   // This is the edge probability matrix.
   edge_probs_matrix epm;
   os << "Generating EPM" << endl;
-  generate_epm(g, otm, epm);
+  generate_epm(g, otm, epm, threads, caches);
+
+  {
+    unsigned long hits = 0, misses = 0;
+    BOOST_FOREACH(const route_cache &c, caches)
+      hits += c.hits(), misses += c.misses();
+
+    if (hits + misses)
+      os << "Routing cache hit rate: "
+         << 100.0 * hits / (hits + misses) << "%" << endl;
+  }
+
+  // The destinations to trace.  In the incremental iteration only
+  // the destinations whose rows of atm or epm changed are traced.
+  vector<bool> changed(num_vertices(g), !history);
+
+  if (history)
+    {
+      reuse(g, tolerance, history->atm, atm, changed);
+      reuse(g, tolerance, history->epm, epm, changed);
+
+      os << "Tracing " << count(changed.begin(), changed.end(), true)
+         << " of " << num_vertices(g) << " destinations" << endl;
+    }
 
   int steps_needed = 0;
 
   // Calculate the needed steps.
   BGL_FORALL_VERTICES(i, g, Graph)
-    BGL_FORALL_VERTICES(j, g, Graph)
-    if (i != j && atm.exists(i, j))
-      steps_needed += HL;
+    if (changed[i])
+      BGL_FORALL_VERTICES(j, g, Graph)
+        if (i != j && atm.exists(i, j))
+          steps_needed += HL;
 
-  progress_display progress(steps_needed, os);
+  parallel_progress progress(steps_needed, os);
 
-  pp_matrix ppm;
-  pt_matrix ptm;
+  // The destinations are independent, and so we process them
+  // concurrently.
+  destination_task task(g, HL, atm, epm, progress, changed, history);
+  parallel_for(num_vertices(g), threads, task);
 
-  // For every destination node i.
+  // Merge the shards of the destinations.  The shards are swapped,
+  // not copied.
   BGL_FORALL_VERTICES(i, g, Graph)
     {
-      // This is the transition matrix.  This matrix is shared
-      // among all packets that have the same destination node.
-      trans_matrix T;
-      generate_T(g, i, epm, T);
+      if (!task.ppms[i].empty())
+        ppm[i].swap(task.ppms[i]);
+      if (!task.ptms[i].empty())
+        ptm[i].swap(task.ptms[i]);
+    }
 
-      // For every source node j.
-      BGL_FORALL_VERTICES(j, g, Graph)
-        if (i != j && atm.exists(i, j))
-          {
-            double admitted = atm.at(i, j);
-            assert(admitted != 0);
-
-            // Packet presence vector.
-            map<Vertex, dist_poly> P;
-            // Here we remember the admission probability.
-            P[j] = dist_poly(distro(poisson(admitted)));
-            ppm[i][j][0] = P;
-
-            // In this loop we trace all the hops of a packet.
-            for(int hop = 1; hop <= HL; ++hop)
-              {
-                // Each loop iteration corresponds to the packet
-                // traversing some links, because it makes one
-                // hop.  For every link we want to know the
-                // polynomial that describes the traversing
-                // packets.
-                map<Vertex, dist_poly> nodes;
-                map<Edge, dist_poly> links;
-
-                make_hop(g, P, T, nodes, links);
-                ppm[i][j][hop] = nodes;
-                ptm[i][j][hop] = links;
-                P = nodes;
-
-                ++progress;
-              }
-          }
+  if (history)
+    {
+      history->atm.swap(atm);
+      history->epm.swap(epm);
+    }
+}
+
+void
+generate_rates(const Graph &g, const fp_matrix &tm, const pt_matrix &ptm,
+               int threads, ana_rates &rates)
+{
+  assert(rates.atm.empty() && rates.otm.empty());
+
+  // This is the matrix of input traffic.
+  fp_matrix itm;
+
+  generate_itm(g, ptm, itm);
+  generate_atm(g, tm, itm, rates.atm, threads);
+  generate_otm(itm, rates.atm, rates.otm);
+}
+
+/**
+ * Summarizes the packet trajectory matrices.
+ */
+static list<ana_rates>
+generate_rates(const Graph &g, const fp_matrix &tm,
+               const list<pt_matrix> &ptm_list, int threads)
+{
+  list<ana_rates> rates_list;
+
+  BOOST_FOREACH(const pt_matrix &ptm, ptm_list)
+    {
+      rates_list.push_back(ana_rates());
+      generate_rates(g, tm, ptm, threads, rates_list.back());
     }
 
+  return rates_list;
+}
+
+boost::tuple<pp_matrix, pt_matrix>
+ana_iteration(const Graph &g, const fp_matrix &tm,
+              int HL, const list<pt_matrix> &ptm_list,
+              ostream &os)
+{
+  return ana_iteration(g, tm, HL, 1, ptm_list, os);
+}
+
+boost::tuple<pp_matrix, pt_matrix>
+ana_iteration(const Graph &g, const fp_matrix &tm,
+              int HL, int threads, const list<pt_matrix> &ptm_list,
+              ostream &os)
+{
+  vector<route_cache> caches(num_vertices(g));
+  return ana_iteration(g, tm, HL, threads, ptm_list, caches, os);
+}
+
+boost::tuple<pp_matrix, pt_matrix>
+ana_iteration(const Graph &g, const fp_matrix &tm,
+              int HL, int threads, const list<pt_matrix> &ptm_list,
+              vector<route_cache> &caches, ostream &os)
+{
+  os << "Generating ITM, ATM and OTM" << endl;
+  return ana_iteration(g, HL, threads,
+                       generate_rates(g, tm, ptm_list, threads),
+                       caches, os);
+}
+
+boost::tuple<pp_matrix, pt_matrix>
+ana_iteration(const Graph &g, int HL, int threads,
+              const list<ana_rates> &rates_list,
+              vector<route_cache> &caches, ostream &os)
+{
+  pp_matrix ppm;
+  pt_matrix ptm;
+  ana_iteration(g, HL, threads, rates_list, caches, 0, 0, ppm, ptm, os);
   return tie(ppm, ptm);
 }
 
+void
+ana_iteration(const Graph &g, int HL, int threads,
+              const list<ana_rates> &rates_list,
+              vector<route_cache> &caches, double tolerance,
+              ana_history &history, ostream &os)
+{
+  assert(tolerance > 0);
+
+  pp_matrix ppm;
+  pt_matrix ptm;
+  ana_iteration(g, HL, threads, rates_list, caches, tolerance, &history,
+                ppm, ptm, os);
+
+  history.ppm.swap(ppm);
+  history.ptm.swap(ptm);
+}
+
 boost::tuple<pp_matrix, pt_matrix>
 ana_solution(const Graph &g, const fp_matrix &tm,
              int HL, int DL, int iters, int AL, ostream &os,
              serializer &s)
 {
-  list<pp_matrix> ppm_list;
-  list<pt_matrix> ptm_list;
+  return ana_solution(g, tm, HL, DL, iters, AL, 1, os, s);
+}
+
+boost::tuple<pp_matrix, pt_matrix>
+ana_solution(const Graph &g, const fp_matrix &tm,
+             int HL, int DL, int iters, int AL, int threads,
+             ostream &os, serializer &s)
+{
+  return ana_solution(g, tm, HL, DL, iters, AL, threads, 0, os, s);
+}
+
+boost::tuple<pp_matrix, pt_matrix>
+ana_solution(const Graph &g, const fp_matrix &tm,
+             int HL, int DL, int iters, int AL, int threads,
+             double tolerance, ostream &os, serializer &s)
+{
+  // The rates of the last AL iterations, which are averaged.
+  list<ana_rates> rates_list;
 
   // By polynomials we model the distance a packet has travelled.  We
   // allow packets to travel DL or less.  Packets are removed if they
   // try to travel more than DL.
   dist_poly::set_S(DL + 1);
 
+  // The routing results of the nodes, kept across the iterations.
+  vector<route_cache> caches(num_vertices(g));
+
+  // The results of the last iteration, which the incremental
+  // iterations reuse.  Only the results of the last iteration are
+  // kept.
+  ana_history history;
+  pp_matrix &ppm = history.ppm;
+  pt_matrix &ptm = history.ptm;
+
+  // The link loads of the previous iteration.
+  map<Edge, double> prev_ll;
+
   for(int iter = 1; iter <= iters; ++iter)
     {
-      pp_matrix ppm;
-      pt_matrix ptm;
       os << "Iteration #" << iter << ": " << endl;
-      tie(ppm, ptm) = ana_iteration(g, tm, HL, ptm_list, os);
+      if (tolerance > 0)
+        ana_iteration(g, HL, threads, rates_list, caches, tolerance,
+                      history, os);
+      else
+        {
+          // The results of the previous iteration are not needed.
+          ppm.clear();
+          ptm.clear();
+
+          boost::tuple<pp_matrix, pt_matrix> r =
+            ana_iteration(g, HL, threads, rates_list, caches, os);
+          ppm.swap(r.get<0>());
+          ptm.swap(r.get<1>());
+        }
 
       s(ptm, iter);
 
-      if (ppm_list.size() == AL)
-        ppm_list.pop_front();
-      ppm_list.push_back(ppm);
-
-      if (ptm_list.size() == AL)
-        ptm_list.pop_front();
-      ptm_list.push_back(ptm);
+      // We keep only the rates of the results.
+      os << "Generating ITM, ATM and OTM" << endl;
+      if (rates_list.size() == AL)
+        rates_list.pop_front();
+      rates_list.push_back(ana_rates());
+      generate_rates(g, tm, ptm, threads, rates_list.back());
+
+      // Stop when the link loads don't change much.
+      if (tolerance > 0)
+        {
+          map<Edge, double> ll;
+          calculate_ll(ptm, ll, g);
+          double residual = max_diff(ll, prev_ll);
+          prev_ll.swap(ll);
+
+          if (iter > 1)
+            {
+              os << "Link-load residual: " << residual << endl;
+              if (residual < tolerance)
+                break;
+            }
+        }
     }
 
-  return tie(ppm_list.back(), ptm_list.back());
+  return tie(ppm, ptm);
 }
 
 boost::tuple<pp_matrix, pt_matrix>
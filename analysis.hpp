@@ -1,13 +1,16 @@
 #ifndef ANALYSIS_HPP
 #define ANALYSIS_HPP
 
+#include "edge_probs.hpp"
 #include "graph.hpp"
 #include "matrixes.hpp"
+#include "route_cache.hpp"
 #include "serializer.hpp"
 
 #include <boost/tuple/tuple.hpp>
 
 #include <list>
+#include <vector>
 
 using namespace std;
 
@@ -15,6 +18,96 @@ boost::tuple<pp_matrix, pt_matrix>
 ana_iteration(const Graph &g, const fp_matrix &tm,
               int HL, const list<pt_matrix> &prev_ptm, ostream &os);
 
+/**
+ * An iteration of the analytical solver, in which the destinations
+ * are processed with the given number of threads.  The results don't
+ * depend on the number of threads.
+ */
+boost::tuple<pp_matrix, pt_matrix>
+ana_iteration(const Graph &g, const fp_matrix &tm,
+              int HL, int threads, const list<pt_matrix> &prev_ptm,
+              ostream &os);
+
+/**
+ * The same as above, but the routing results of node j are cached in
+ * caches[j], which should be kept across the iterations.
+ */
+boost::tuple<pp_matrix, pt_matrix>
+ana_iteration(const Graph &g, const fp_matrix &tm,
+              int HL, int threads, const list<pt_matrix> &prev_ptm,
+              vector<route_cache> &caches, ostream &os);
+
+/**
+ * The results of the previous analytical iteration, which the
+ * incremental iterations reuse.  It's empty before the first
+ * iteration.
+ */
+struct ana_history
+{
+  /// The admitted traffic matrix.
+  fp_matrix atm;
+
+  /// The edge probability matrix.
+  edge_probs_matrix epm;
+
+  /// The packet presence matrix.
+  pp_matrix ppm;
+
+  /// The packet trajectory matrix.
+  pt_matrix ptm;
+};
+
+/**
+ * The rates of an iteration that the next iterations need.  We keep
+ * them instead of the packet trajectory matrix they come from,
+ * because they are much smaller.
+ */
+struct ana_rates
+{
+  /// The admitted traffic matrix.
+  fp_matrix atm;
+
+  /// The output traffic matrix.
+  fp_matrix otm;
+};
+
+/**
+ * Generates the rates of the packet trajectory matrix ptm.  The
+ * rates should be empty.
+ */
+void
+generate_rates(const Graph &g, const fp_matrix &tm, const pt_matrix &ptm,
+               int threads, ana_rates &rates);
+
+/**
+ * The same as the iteration with the routing caches above, but with
+ * the rates of the previous iterations given instead of their packet
+ * trajectory matrices.  The rates are averaged.
+ */
+boost::tuple<pp_matrix, pt_matrix>
+ana_iteration(const Graph &g, int HL, int threads,
+              const list<ana_rates> &rates_list,
+              vector<route_cache> &caches, ostream &os);
+
+/**
+ * The incremental iteration.  The admission rates and the edge
+ * probabilities that changed by less than the tolerance since the
+ * previous iteration are taken from the history.  Only the
+ * destinations whose admission rates or edge probabilities changed
+ * are traced, and the results of the other destinations are taken
+ * from the history.  The results of this iteration are put into the
+ * history.
+ *
+ * @param tolerance the tolerance, positive
+ *
+ * @param history the results of the previous iteration
+ */
+void
+ana_iteration(const Graph &g, int HL, int threads,
+              const list<ana_rates> &rates_list,
+              vector<route_cache> &caches, double tolerance,
+              ana_history &history, ostream &os);
+
 /**
  * The analytical solver.
  *
@@ -43,4 +136,28 @@ boost::tuple<pp_matrix, pt_matrix>
 ana_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
              int iters, int AL, ostream &os);
 
+/**
+ * The analytical solver, which processes the destinations with the
+ * given number of threads.
+ *
+ * @param threads the number of threads
+ */
+boost::tuple<pp_matrix, pt_matrix>
+ana_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
+             int iters, int AL, int threads, ostream &os,
+             serializer &s);
+
+/**
+ * The analytical solver, which with a positive tolerance makes the
+ * incremental iterations, and stops when the largest change of a
+ * link load between two iterations is below the tolerance.  With
+ * zero tolerance it's the same as above.
+ *
+ * @param tolerance the tolerance, or 0 for none
+ */
+boost::tuple<pp_matrix, pt_matrix>
+ana_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
+             int iters, int AL, int threads, double tolerance,
+             ostream &os, serializer &s);
+
 #endif /* ANALYSIS_HPP */
@@ -61,6 +61,37 @@ process_args(int argc, char * argv[])
         ("step,s", po::value<int>()->default_value(0),
          "the step for saving results")
 
+        ("tolerance", po::value<double>()->default_value(0),
+         "the tolerance of incremental analysis, 0 to run all iterations")
+
+        ("epsilon", po::value<double>()->default_value(0),
+         "the largest probability of the tail cut off the sums of "
+         "tabular distributions")
+
+        ("threads,j", po::value<int>()->default_value(1),
+         "the number of threads of simulation or analysis")
+
+        ("replications,r", po::value<int>()->default_value(1),
+         "the number of simulation replications")
+
+        ("precision", po::value<double>()->default_value(0),
+         "the relative precision of simulation, 0 to run all time slots")
+
+        ("max-slots", po::value<int>()->default_value(100000),
+         "the largest number of time slots of simulation")
+
+        ("events",
+         "simulate only the nodes with packets, faster for low loads; "
+         "uses one thread per replication")
+
+        ("checkpoint", po::value<string>(),
+         "the prefix of the names of the simulation checkpoint files")
+
+        ("checkpoint-slots", po::value<int>()->default_value(10000),
+         "the number of time slots between checkpoints")
+
+        ("resume", "resume the simulation from the checkpoints")
+
         ("topology,t", po::value<string>(),
          "name of the Graphviz file with topology")
 
@@ -68,7 +99,9 @@ process_args(int argc, char * argv[])
          "name of the file with traffic matrix")
 
         ("output,o", po::value<string>(),
-         "name of the output file");
+         "name of the output file")
+
+        ("binary", "save the results in the binary format");
 
       po::variables_map vm;
       po::store(po::command_line_parser(argc, argv).options(opts).run(), vm);
@@ -99,6 +132,8 @@ process_args(int argc, char * argv[])
       if(vm.count("output"))
         result.output_filename = vm["output"].as<string>();
 
+      result.binary = vm.count("binary");
+
       if (vm.count("analysis") && vm.count("simulation"))
         {
           cerr << "You can choose only one of '-A' or '-S'.\n";
@@ -141,8 +176,29 @@ process_args(int argc, char * argv[])
 
           result.iters = vm["iters"].as<int>();
           result.step = vm["step"].as<int>();
+          result.tolerance = vm["tolerance"].as<double>();
+
+          if (result.tolerance < 0)
+            {
+              cerr << "You gave me a wrong tolerance.  "
+                   << "I need a non-negative tolerance.\n";
+              exit(1);
+            }
         }
 
+      result.epsilon = vm["epsilon"].as<double>();
+      result.threads = vm["threads"].as<int>();
+      result.replications = vm["replications"].as<int>();
+      result.precision = vm["precision"].as<double>();
+      result.max_slots = vm["max-slots"].as<int>();
+      result.events = vm.count("events");
+
+      if (vm.count("checkpoint"))
+        result.checkpoint = vm["checkpoint"].as<string>();
+
+      result.checkpoint_slots = vm["checkpoint-slots"].as<int>();
+      result.resume = vm.count("resume");
+
       if (vm.count("DL"))
         result.DL = vm["DL"].as<int>();
       else
@@ -162,6 +218,54 @@ process_args(int argc, char * argv[])
           cerr << "You gave me a wrong DL.  I need a positive DL.\n";
           exit(1);
         }
+
+      if (result.epsilon < 0)
+        {
+          cerr << "You gave me a wrong epsilon.  "
+               << "I need a non-negative epsilon.\n";
+          exit(1);
+        }
+
+      if (result.threads <= 0)
+        {
+          cerr << "You gave me a wrong number of threads.  "
+               << "I need a positive number.\n";
+          exit(1);
+        }
+
+      if (result.replications <= 0)
+        {
+          cerr << "You gave me a wrong number of replications.  "
+               << "I need a positive number.\n";
+          exit(1);
+        }
+
+      if (result.precision < 0)
+        {
+          cerr << "You gave me a wrong precision.  "
+               << "I need a non-negative precision.\n";
+          exit(1);
+        }
+
+      if (result.max_slots <= 0)
+        {
+          cerr << "You gave me a wrong number of time slots.  "
+               << "I need a positive number.\n";
+          exit(1);
+        }
+
+      if (result.checkpoint_slots <= 0)
+        {
+          cerr << "You gave me a wrong number of checkpoint slots.  "
+               << "I need a positive number.\n";
+          exit(1);
+        }
+
+      if (result.resume && result.checkpoint.empty())
+        {
+          cerr << "You need to give me the checkpoint to resume from.\n";
+          exit(1);
+        }
     }
   catch(const std::exception& e)
     {
@@ -65,6 +65,41 @@ public:
 
   /// Average limit;
   int AL;
+
+  /// The tolerance of the incremental analysis, or 0 for none.
+  double tolerance;
+
+  /// The largest probability of the tail cut off the sums of the
+  /// tabular distributions.
+  double epsilon;
+
+  /// If true, save the results in the binary result archive.
+  bool binary;
+
+  /// The number of threads of simulation or analysis.
+  int threads;
+
+  /// The number of simulation replications.
+  int replications;
+
+  /// The relative precision of simulation, or 0 for none.
+  double precision;
+
+  /// The largest number of time slots of a simulation replication.
+  int max_slots;
+
+  /// If true, simulate only the nodes with packets.
+  bool events;
+
+  /// The prefix of the names of the checkpoint files, or empty for
+  /// none.
+  string checkpoint;
+
+  /// The number of time slots between checkpoints.
+  int checkpoint_slots;
+
+  /// If true, resume the simulation from the checkpoints.
+  bool resume;
 };
 
 bool operator == (const arguments &, const arguments &);
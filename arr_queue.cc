@@ -1,18 +1,53 @@
 #include "arr_queue.hpp"
 #include "utils.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 
+#include <boost/functional/hash.hpp>
+
 using namespace std;
 
+bool
+arr_queue::entry_order::operator()(const entry &e1, const entry &e2) const
+{
+  if (e1.first != e2.first)
+    return e1.first < e2.first;
+
+  // The same probability, and so the arrangement that is
+  // lexicographically larger is less important.
+  size_t k = q->distros.size();
+  vector<int>::const_iterator a1 = q->arena.begin() + e1.second;
+  vector<int>::const_iterator a2 = q->arena.begin() + e2.second;
+
+  return lexicographical_compare(a2, a2 + k, a1, a1 + k);
+}
+
+size_t
+arr_queue::arr_hash::operator()(size_t o) const
+{
+  vector<int>::const_iterator a = q->arena.begin() + o;
+  return boost::hash_range(a, a + q->distros.size());
+}
+
+bool
+arr_queue::arr_equal::operator()(size_t o1, size_t o2) const
+{
+  vector<int>::const_iterator a1 = q->arena.begin() + o1;
+  vector<int>::const_iterator a2 = q->arena.begin() + o2;
+
+  return equal(a1, a1 + q->distros.size(), a2);
+}
+
 arr_queue::arr_queue(const vector<distro> &d) :
-  distros(d), ratio(default_ratio), size(0)
+  distros(d), ratio(default_ratio),
+  visited(0, arr_hash(this), arr_equal(this))
 {
   // Initialize the queue with the most probable arrangement.
-  vector<int> first_arr(d.size(), 0);
-  max_prob = calc_arr_prob(first_arr);
-  push(first_arr);
+  arena.resize(d.size(), 0);
+  max_prob = calc_arr_prob(0);
+  push();
 }
 
 bool
@@ -22,9 +57,13 @@ arr_queue::find_next(vector<int> &arr, double &prob)
   if (q.empty())
     return false;
 
-  // Pop the most probable arrangement and calculate its probability.
-  pop(arr);
-  prob = calc_arr_prob(arr);
+  // Pop the most probable arrangement, which comes with its
+  // probability.
+  entry e = pop();
+  prob = e.first;
+
+  size_t k = distros.size();
+  arr.assign(arena.begin() + e.second, arena.begin() + e.second + k);
 
   // If need be, return no more arrangements, when this one is already
   // below the cut off ratio.
@@ -36,66 +75,60 @@ arr_queue::find_next(vector<int> &arr, double &prob)
 	return false;
     }
 
-  for(int i = 0; i < arr.size(); ++i)
-    {
-      // This is the new arrangement.
-      vector<int> n = arr;
-      ++n[i];
-
-      // We push the new arrangement into the queue only if the
-      // distribution distros[i] has n[i]-th largest value.
-      if (distros[i].exists_ith_max(n[i]))
-        push(n);
-    }
+  for(int i = 0; i < k; ++i)
+    // We push the new arrangement into the queue only if the
+    // distribution distros[i] has (arr[i] + 1)-th largest value.
+    if (distros[i].exists_ith_max(arr[i] + 1))
+      {
+        // This is the new arrangement at the end of the arena.
+        size_t o = arena.size();
+        arena.insert(arena.end(), arr.begin(), arr.end());
+        ++arena[o + i];
+        push();
+      }
 
   return true;
 }
 
 void
-arr_queue::push(const vector<int> &arr)
+arr_queue::push()
 {
-  assert(arr.size() == distros.size());
-  double prob = calc_arr_prob(arr);
-  q[prob].insert(arr);
-  ++size;
+  size_t k = distros.size();
+  assert(arena.size() >= k);
+  size_t o = arena.size() - k;
+
+  // The arrangement has been pushed already.
+  if (!visited.insert(o).second)
+    {
+      arena.resize(o);
+      return;
+    }
+
+  q.push_back(entry(calc_arr_prob(o), o));
+  push_heap(q.begin(), q.end(), entry_order(this));
 }
 
-void
-arr_queue::pop(vector<int> &arr)
+arr_queue::entry
+arr_queue::pop()
 {
   assert(!q.empty());
 
-  // This is the pair which has the largest value.
-  queue_type::iterator c = q.begin();
-
-  // The set of arrangements cannot be empty.
-  assert(c->second.size());
+  pop_heap(q.begin(), q.end(), entry_order(this));
+  entry e = q.back();
+  q.pop_back();
 
-  // This is the first arrangement in this set of arrangements.
-  set<vector<int> >::iterator ai = c->second.begin();
-
-  // This is the arrangement that we return.
-  arr = (*ai);
-
-  // Remove the processed arrangement.
-  c->second.erase(ai);
-
-  // Erase the value if its set is empty.
-  if (c->second.empty())
-    q.erase(c);
-
-  --size;
+  return e;
 }
 
 double
-arr_queue::calc_arr_prob(const vector<int> &arr)
+arr_queue::calc_arr_prob(size_t o) const
 {
-  assert(distros.size() == arr.size());
+  assert(o + distros.size() <= arena.size());
 
   double prob = 1;
 
-  for(unsigned i = 0; i < arr.size(); ++i)
-    prob *= distros[i].get_ith_max(arr[i]).first;
+  for(unsigned i = 0; i < distros.size(); ++i)
+    prob *= distros[i].get_ith_max(arena[o + i]).first;
 
   return prob;
 }
@@ -109,21 +142,36 @@ arr_queue::set_ratio(double ratio)
 int
 arr_queue::get_size() const
 {
-  return size;
+  return q.size();
 }
 
 ostream &
 operator << (ostream &out, const arr_queue &q)
 {
-  for(arr_queue::queue_type::const_iterator
-        i = q.q.begin(); i != q.q.end(); ++i)
+  // The entries sorted from the most probable.
+  vector<arr_queue::entry> entries(q.q);
+  sort(entries.begin(), entries.end(), arr_queue::entry_order(&q));
+  reverse(entries.begin(), entries.end());
+
+  size_t k = q.distros.size();
+
+  for(vector<arr_queue::entry>::const_iterator
+        i = entries.begin(); i != entries.end(); ++i)
     {
-      out << "Arrangements with probability " << i->first << ": ";
-      for(arr_queue::queue_type::mapped_type::const_iterator
-            j = i->second.begin(); j != i->second.end(); ++j)
-        out << "<" << *j << ">" << ", ";
-      out << endl;
+      if (i == entries.begin() || i->first != (i - 1)->first)
+        {
+          if (i != entries.begin())
+            out << endl;
+          out << "Arrangements with probability " << i->first << ": ";
+        }
+
+      vector<int> arr(q.arena.begin() + i->second,
+                      q.arena.begin() + i->second + k);
+      out << "<" << arr << ">" << ", ";
     }
 
+  if (!entries.empty())
+    out << endl;
+
   return out;
 }
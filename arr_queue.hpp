@@ -4,12 +4,12 @@
 #include "config.hpp"
 #include "distro.hpp"
 
-#include <functional>
+#include <cstddef>
 #include <iostream>
-#include <map>
-#include <set>
 #include <vector>
 
+#include <boost/unordered_set.hpp>
+
 /**
  * The queue of the most probable arrangements.
  */
@@ -17,11 +17,6 @@ class arr_queue
 {
   friend ostream & operator << (ostream &out, const arr_queue &q);
 
-  /**
-   * Keeps track of the size of the queue.
-   */
-  int size;
-
   /**
    * The probability of the most probable arrangement.
    */
@@ -33,23 +28,72 @@ class arr_queue
   vector<distro> distros;
 
   /**
-   * This is the queue of waiting arrangements.
-   *
-   * The key of the map is the probability of an arrangement, and the
-   * value is the set of arrangements with that probability.  We need
-   * a set, because there can be various arrangements with the same
-   * probability.
-   *
-   * We sort the map with decreasing probabilities, and that's why we
-   * use the "greater" class.
+   * The arrangements are kept one after another in this arena, and
+   * an arrangement is identified by the offset of its first element.
+   * An arrangement has distros.size() elements.
+   */
+  vector<int> arena;
+
+  /**
+   * The entry of the queue: the probability of an arrangement and
+   * the offset of the arrangement in the arena.
+   */
+  typedef pair<double, size_t> entry;
+
+  /**
+   * The order of entries in the heap.  An entry is more important if
+   * it has a larger probability, or the same probability and the
+   * lexicographically smaller arrangement.
+   */
+  class entry_order
+  {
+    const arr_queue *q;
+
+  public:
+    entry_order(const arr_queue *q) : q(q) {}
+
+    bool operator()(const entry &e1, const entry &e2) const;
+  };
+
+  /**
+   * The hash of an arrangement given by its offset.
+   */
+  class arr_hash
+  {
+    const arr_queue *q;
+
+  public:
+    arr_hash(const arr_queue *q) : q(q) {}
+
+    size_t operator()(size_t o) const;
+  };
+
+  /**
+   * Tells whether the arrangements given by their offsets are equal.
+   */
+  class arr_equal
+  {
+    const arr_queue *q;
+
+  public:
+    arr_equal(const arr_queue *q) : q(q) {}
+
+    bool operator()(size_t o1, size_t o2) const;
+  };
+
+  /**
+   * The queue of waiting arrangements, which is a binary heap with
+   * the most probable arrangement at the front.
    */
-  typedef map<double, set<vector<int> >, greater<double> > queue_type;
+  vector<entry> q;
 
   /**
-   * The queue of arrangements from which the most probable
-   * arrangement is chosen.
+   * The offsets of all the arrangements that have ever been pushed,
+   * so that we push an arrangement only once, even though it can be
+   * reached from several arrangements.
    */
-  queue_type q;
+  typedef boost::unordered_set<size_t, arr_hash, arr_equal> visited_type;
+  visited_type visited;
 
   /**
    * When we consider packet arrangements, there is one the most
@@ -103,35 +147,42 @@ public:
 private:
 
   /**
-   * Pushes the arrangement into the queue.
-   *
-   * @param the arrangement to push
+   * The queue refers to itself in its hash set, and so it can't be
+   * copied.
+   */
+  arr_queue(const arr_queue &);
+  arr_queue &operator = (const arr_queue &);
+
+  /**
+   * Pushes the arrangement at the end of the arena into the queue,
+   * unless it has been pushed already, in which case it's removed
+   * from the arena.
    */
   void
-  push(const vector<int> &arr);
+  push();
 
   /**
-   * Pops an arrangement from the queue.
+   * Pops the most probable arrangement from the queue.
    *
-   * @param next_arr keeps the arrangement popped
+   * @return the entry of the arrangement popped
    */
-  void
-  pop(vector<int> &next_arr);
+  entry
+  pop();
 
   /**
    * This function calculates the probability of the given arrangement
    * of packets of k groups.  The probability distribution of each
    * group is given by the distros vector of size k.  The specific
-   * arrangement is given by the arr vector also of size k.
+   * arrangement is given by the k elements of the arena at offset o.
    *
-   * @param arr describes the arrangement; arr[i] says how many
-   * packets there are that belong to group i, which are described by
-   * the distros[i] probability distribution
+   * @param o the offset of the arrangement; arena[o + i] says how
+   * many packets there are that belong to group i, which are
+   * described by the distros[i] probability distribution
    *
    * @return probability of arrangement
    */
   double
-  calc_arr_prob(const vector<int> &arr);
+  calc_arr_prob(size_t o) const;
 };
 
 /**
@@ -0,0 +1,108 @@
+#include "batch_means.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <gsl/gsl_cdf.h>
+
+#include <boost/graph/iteration_macros.hpp>
+
+/**
+ * The smallest number of batches after the warm-up period, for which
+ * we trust the confidence intervals.
+ */
+#define MIN_BATCHES 10
+
+batch_means::batch_means(const Graph &g, double precision,
+                         int batch_size, double level) :
+  precision(precision), batch_size(batch_size), level(level),
+  warm(false), last_load(-1)
+{
+  int nv = num_vertices(g);
+
+  // The graph is undirected, and so every edge gives two links.
+  BGL_FORALL_EDGES(e, g, Graph)
+    {
+      Vertex s = source(e, g);
+      Vertex t = target(e, g);
+      int c = get(edge_weight2, g, e);
+
+      links.push_back(s * nv + t);
+      capacities.push_back(c);
+      links.push_back(t * nv + s);
+      capacities.push_back(c);
+    }
+}
+
+bool
+batch_means::add(const batch_counts &bc)
+{
+  std::vector<double> sample;
+
+  double load = 0;
+
+  for(int l = 0; l < links.size(); ++l)
+    {
+      double ll = (double)bc.transits[links[l]]
+        / batch_size / capacities[l];
+      sample.push_back(ll);
+      load += ll;
+    }
+
+  if (!links.empty())
+    load /= links.size();
+
+  // The packet loss probability.
+  sample.push_back(bc.offered ? 1 - (double)bc.delivered / bc.offered : 0);
+
+  if (warm)
+    {
+      samples.push_back(sample);
+      return false;
+    }
+
+  // The warm-up period is over when the average link load levels off.
+  if (last_load >= 0 &&
+      std::abs(load - last_load) <= precision * std::max(load, last_load))
+    warm = true;
+
+  last_load = load;
+
+  return warm;
+}
+
+bool
+batch_means::warmed_up() const
+{
+  return warm;
+}
+
+bool
+batch_means::converged() const
+{
+  int n = samples.size();
+
+  if (n < MIN_BATCHES)
+    return false;
+
+  // The quantile of the Student's t-distribution.
+  double t = gsl_cdf_tdist_Pinv((1 + level) / 2, n - 1);
+
+  for(int k = 0; k < samples[0].size(); ++k)
+    {
+      double mean = 0;
+      for(int b = 0; b < n; ++b)
+        mean += samples[b][k];
+      mean /= n;
+
+      double s2 = 0;
+      for(int b = 0; b < n; ++b)
+        s2 += (samples[b][k] - mean) * (samples[b][k] - mean);
+      s2 /= n - 1;
+
+      if (t * sqrt(s2 / n) > precision * mean)
+        return false;
+    }
+
+  return true;
+}
@@ -0,0 +1,99 @@
+#ifndef BATCH_MEANS_HPP
+#define BATCH_MEANS_HPP
+
+#include "graph.hpp"
+#include "sim_stats.hpp"
+
+#include <vector>
+
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/vector.hpp>
+
+/**
+ * Tells whether the simulation converged with the method of batch
+ * means.  The simulation time is divided into batches of time slots,
+ * and for every batch we get the batch means of the link loads and
+ * the packet loss probability.  These are the same quantities that
+ * the calculate_ll and check_plp functions produce from the results.
+ *
+ * The first batches are the warm-up period, which ends when the
+ * average link load of a batch differs from that of the previous
+ * batch by no more than the given precision.  The batches of the
+ * warm-up period are discarded.
+ *
+ * After the warm-up period, the simulation converged when for every
+ * batch mean the half-width of its confidence interval is no larger
+ * than the given precision times the mean.
+ */
+class batch_means
+{
+  friend class boost::serialization::access;
+
+  /// Only the state is serialized, since the rest is given by the
+  /// graph and the arguments of the constructor.
+  template<class Archive>
+  void serialize(Archive &ar, const unsigned int)
+  {
+    ar & warm;
+    ar & last_load;
+    ar & samples;
+  }
+
+  /// The links, i.e. the indexes of their transits in batch_counts.
+  std::vector<int> links;
+
+  /// The capacities of the links.
+  std::vector<int> capacities;
+
+  /// The relative precision.
+  double precision;
+
+  /// The number of time slots in a batch.
+  int batch_size;
+
+  /// The confidence level.
+  double level;
+
+  /// True if the warm-up period is over.
+  bool warm;
+
+  /// The average link load of the previous batch.
+  double last_load;
+
+  /// The samples of the batches after the warm-up period.  Element
+  /// [b][l] is the load of link l in batch b, and the last element of
+  /// a batch is the packet loss probability.
+  std::vector<std::vector<double> > samples;
+
+public:
+  /**
+   * @param g the graph
+   *
+   * @param precision the relative precision
+   *
+   * @param batch_size the number of time slots in a batch
+   *
+   * @param level the confidence level
+   */
+  batch_means(const Graph &g, double precision, int batch_size,
+              double level);
+
+  /**
+   * Adds the counts of the next batch.
+   *
+   * @return true if this batch ended the warm-up period
+   */
+  bool add(const batch_counts &bc);
+
+  /**
+   * Returns true if the warm-up period is over.
+   */
+  bool warmed_up() const;
+
+  /**
+   * Returns true if the simulation converged.
+   */
+  bool converged() const;
+};
+
+#endif /* BATCH_MEANS_HPP */
@@ -0,0 +1,46 @@
+#include "calendar_queue.hpp"
+
+#include <cassert>
+
+calendar_queue::calendar_queue(int width) : buckets(width), nr(0)
+{
+  assert(width >= 1);
+}
+
+void
+calendar_queue::insert(packet *pkt)
+{
+  buckets[pkt->next_ts % buckets.size()].push_back(pkt);
+  ++nr;
+}
+
+void
+calendar_queue::pop(timeslot ts, slot_pkts &pkts)
+{
+  slot_pkts &b = buckets[ts % buckets.size()];
+
+  for(slot_pkts::iterator i = b.begin(); i != b.end(); ++i)
+    {
+      // Make sure the bucket holds packets of one time slot only.
+      assert((*i)->next_ts == ts);
+      pkts.push_back(*i);
+    }
+
+  nr -= b.size();
+
+  // The clear function keeps the memory of the bucket for later.
+  b.clear();
+}
+
+void
+calendar_queue::packets(slot_pkts &pkts) const
+{
+  for(int i = 0; i < buckets.size(); ++i)
+    pkts.insert(pkts.end(), buckets[i].begin(), buckets[i].end());
+}
+
+int
+calendar_queue::size() const
+{
+  return nr;
+}
@@ -0,0 +1,58 @@
+#ifndef CALENDAR_QUEUE_HPP
+#define CALENDAR_QUEUE_HPP
+
+#include "config.hpp"
+#include "packet.hpp"
+
+#include <vector>
+
+/**
+ * The queue of packets that arrive at a node.  It's a calendar queue
+ * (also known as a timing wheel): packets are kept in buckets indexed
+ * with their next_ts modulo the width of the queue.  A packet arrives
+ * at most the largest link distance after it was sent, and so with
+ * the width larger than the largest link distance, a bucket holds the
+ * packets of a single time slot only.
+ *
+ * Packets of a bucket are kept in the order they were inserted.
+ */
+class calendar_queue
+{
+  /// The buckets of packets.
+  std::vector<slot_pkts> buckets;
+
+  /// The number of packets in the queue.
+  int nr;
+
+public:
+  /**
+   * Creates the queue of the given width, which should be larger than
+   * the largest link distance.
+   */
+  calendar_queue(int width);
+
+  /**
+   * Inserts the packet into the bucket of its next_ts.
+   */
+  void insert(packet *pkt);
+
+  /**
+   * Appends to pkts the packets that arrive in time slot ts, and
+   * removes them from the queue.
+   */
+  void pop(timeslot ts, slot_pkts &pkts);
+
+  /**
+   * Appends to pkts all the packets in the queue, bucket by bucket,
+   * without removing them.  Inserting them in this order into an
+   * empty queue of the same width gives the same queue.
+   */
+  void packets(slot_pkts &pkts) const;
+
+  /**
+   * Returns the number of packets in the queue.
+   */
+  int size() const;
+};
+
+#endif /* CALENDAR_QUEUE_HPP */
@@ -0,0 +1,95 @@
+#include "checkpoint.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include <boost/bind.hpp>
+
+checkpoint_writer::checkpoint_writer() :
+  done(false), t(boost::bind(&checkpoint_writer::run, this))
+{
+}
+
+checkpoint_writer::~checkpoint_writer()
+{
+  {
+    boost::mutex::scoped_lock lock(m);
+    done = true;
+  }
+
+  cv.notify_one();
+  t.join();
+}
+
+void
+checkpoint_writer::write(const string &name, string &data)
+{
+  {
+    boost::mutex::scoped_lock lock(m);
+    pending[name].swap(data);
+  }
+
+  data.clear();
+  cv.notify_one();
+}
+
+void
+checkpoint_writer::run()
+{
+  while(true)
+    {
+      string name, data;
+
+      {
+        boost::mutex::scoped_lock lock(m);
+
+        while(pending.empty() && !done)
+          cv.wait(lock);
+
+        // We're done when all the checkpoints are written.
+        if (pending.empty())
+          return;
+
+        name = pending.begin()->first;
+        data.swap(pending.begin()->second);
+        pending.erase(pending.begin());
+      }
+
+      // The file is written without the lock, so that the simulation
+      // can hand over the next checkpoints.
+      if (!write_checkpoint(name, data))
+        cerr << "Can't save the checkpoint " << name << endl;
+    }
+}
+
+bool
+write_checkpoint(const string &name, const string &data)
+{
+  string tmp = name + ".tmp";
+
+  {
+    ofstream out(tmp.c_str(), ios::binary);
+    out.write(data.data(), data.size());
+    out.close();
+
+    if (!out)
+      return false;
+  }
+
+  return !rename(tmp.c_str(), name.c_str());
+}
+
+bool
+read_checkpoint(const string &name, string &data)
+{
+  ifstream in(name.c_str(), ios::binary);
+
+  if (!in)
+    return false;
+
+  data.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+
+  return !in.bad();
+}
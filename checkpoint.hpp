@@ -0,0 +1,77 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <map>
+#include <string>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace std;
+
+/**
+ * Writes the checkpoints in the background.  The simulation hands
+ * over the serialized checkpoint, and goes on, while the thread of
+ * the writer puts it in the file.  If the simulation hands over the
+ * next checkpoint of a file before the previous one was written, the
+ * previous one is dropped, and so the simulation never waits for the
+ * disk.
+ */
+class checkpoint_writer
+{
+  /// The checkpoints waiting to be written, by the file name.
+  map<string, string> pending;
+
+  /// True when the thread is to finish.
+  bool done;
+
+  /// Guards the pending checkpoints and the done flag.
+  boost::mutex m;
+  boost::condition_variable cv;
+
+  /// The thread that writes the checkpoints.  It's the last member,
+  /// so that the thread starts when the others are ready.
+  boost::thread t;
+
+  /// Writes the checkpoints until done.
+  void run();
+
+  // We don't want to copy the writer.
+  checkpoint_writer(const checkpoint_writer &);
+  checkpoint_writer &operator = (const checkpoint_writer &);
+
+public:
+  checkpoint_writer();
+
+  /**
+   * Writes the checkpoints still waiting, and stops the thread.
+   */
+  ~checkpoint_writer();
+
+  /**
+   * Schedules the data to be written to the file.  The data is taken
+   * over, and so it's left empty.
+   */
+  void write(const string &name, string &data);
+};
+
+/**
+ * Writes the checkpoint to the file.  The data is first written to a
+ * temporary file, which then replaces the file, and so the file
+ * always has a complete checkpoint.
+ *
+ * @return true on success
+ */
+bool
+write_checkpoint(const string &name, const string &data);
+
+/**
+ * Reads the checkpoint from the file.
+ *
+ * @return true on success
+ */
+bool
+read_checkpoint(const string &name, string &data);
+
+#endif /* CHECKPOINT_HPP */
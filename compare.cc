@@ -1,36 +1,32 @@
 #include "arguments.hpp"
 #include "compare_args.hpp"
 #include "graph.hpp"
-#include "graph_serialization.hpp"
 #include "matrixes.hpp"
+#include "parallel.hpp"
+#include "result_reader.hpp"
 #include "test.hpp"
 #include "utils.hpp"
 
 #include <cmath>
 #include <iostream>
-#include <fstream>
+#include <map>
 #include <set>
+#include <string>
+#include <vector>
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 #include <boost/accumulators/statistics/mean.hpp>
 #include <boost/accumulators/statistics/variance.hpp>
-#include <boost/archive/text_iarchive.hpp>
 #include <boost/filesystem/operations.hpp>
-#include <boost/serialization/string.hpp>
 
 using namespace boost::accumulators;
 using namespace boost::filesystem;
 
 void
-compare_ll(const pt_matrix &ptm1, const Graph &g1,
-           const pt_matrix &ptm2, const Graph &g2,
-           const compare_args &args)
+compare_ll(map<Edge, double> &ll1, const Graph &g1,
+           map<Edge, double> &ll2, const compare_args &args)
 {
-  map<Edge, double> ll1, ll2;
-  calculate_ll(ptm1, ll1, g1);
-  calculate_ll(ptm2, ll2, g2);
-
   // These are the edges used in either or both maps.
   set<Edge> present;
 
@@ -131,27 +127,54 @@ file_exists(const string &ifn)
   return true;
 }
 
-bool
-load_archive(const string &ifn, arguments &a, Graph &g, fp_matrix &tm,
-             pt_matrix &ptm)
+/**
+ * Collects the link loads.
+ */
+class ll_subscriber: public result_subscriber
 {
-  ifstream ifs(ifn.c_str());
-
-  if(!ifs)
-    {
-      cerr << "Can't open " << ifn <<  " \n";
-      return false;
-    }
-
-  boost::archive::text_iarchive ia(ifs);
-  ia >> a;
-  ia >> g;
-  p_graph = &g;
-  ia >> tm;
-  ia >> ptm;
-
-  return true;
-}
+public:
+  map<Edge, double> ll;
+
+  void
+  link_load(Edge e, double load)
+  {
+    ll[e] = load;
+  }
+};
+
+/**
+ * The results of an input.
+ */
+struct input
+{
+  arguments a;
+  Graph g;
+  fp_matrix tm;
+  ll_subscriber s;
+  bool loaded;
+};
+
+/**
+ * Loads the inputs.  The read_results function has no global state,
+ * and so the inputs are loaded concurrently.
+ */
+class load_task
+{
+  const vector<string> &file_names;
+  input *inputs;
+
+public:
+  load_task(const vector<string> &file_names, input *inputs) :
+    file_names(file_names), inputs(inputs)
+  {
+  }
+
+  void operator()(int i)
+  {
+    input &in = inputs[i];
+    in.loaded = read_results(file_names[i], in.a, in.g, in.tm, in.s);
+  }
+};
 
 int main(int argc, char* argv[])
 {
@@ -163,28 +186,24 @@ int main(int argc, char* argv[])
       return 1;
     }
 
-  arguments a1, a2;
-  Graph g1, g2;
-  fp_matrix tm1, tm2;
-  pt_matrix ptm1, ptm2;
-
   if (!file_exists(args.file_names[0]))
     return 1;
 
   if (!file_exists(args.file_names[1]))
     return 1;
 
-  if (!load_archive(args.file_names[0], a1, g1, tm1, ptm1))
-    return 1;
+  input inputs[2];
+  load_task task(args.file_names, inputs);
+  parallel_for(2, 2, task);
 
-  if (!load_archive(args.file_names[1], a2, g2, tm2, ptm2))
+  if (!inputs[0].loaded || !inputs[1].loaded)
     return 1;
 
   // Check the arguments loaded from the archives.
-  check_args(a1, a2);
-  TEST(test_graphs(g1, g2));
+  check_args(inputs[0].a, inputs[1].a);
+  TEST(test_graphs(inputs[0].g, inputs[1].g));
 
-  compare_ll(ptm1, g1, ptm2, g2, args);
+  compare_ll(inputs[0].s.ll, inputs[0].g, inputs[1].s.ll, args);
 
   return 0;
 }
@@ -3,13 +3,16 @@
 
 #include <cstdlib>
 
+#include <boost/detail/atomic_count.hpp>
+
 /**
  * This class keeps track of the number of objects of your class.
  *
  * To use it, derive your class privatelly from it.  And then make the
  * how_many function publically available in your class.  The how_many
  * class will tell the number of all objects of your class, be it
- * static, global, automatic or dynamic.
+ * static, global, automatic or dynamic.  The count is atomic, because
+ * objects are created and destroyed by many threads.
  *
  * Example:
  *
@@ -47,12 +50,12 @@ public:
   }
   
 private:
-  static size_t count;
+  static boost::detail::atomic_count count;
 };
 
 
 template<typename T>
-size_t
-counter<T>::count = 0;
+boost::detail::atomic_count
+counter<T>::count(0);
 
 #endif /* COUNTER_HPP */
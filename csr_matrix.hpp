@@ -0,0 +1,156 @@
+#ifndef CSR_MATRIX_HPP
+#define CSR_MATRIX_HPP
+
+#include "sparse_matrix.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * A sparse matrix in the compressed sparse row format.  It's built
+ * from a sparse_matrix once the sparse_matrix is complete, and then
+ * it's read-only.  The elements are kept contiguously row by row,
+ * sorted by the column, and so iterating over them doesn't chase
+ * pointers like iterating over the maps of sparse_matrix does.
+ *
+ * The rows are numbered from 0 to (rows() - 1) in the order of their
+ * keys, and only the rows that have elements are kept.
+ */
+template <typename K, typename T>
+class csr_matrix
+{
+public:
+  /// An element of a row: the column key and the value.
+  typedef pair<K, T> value_type;
+
+  /// The iterator over the elements of a row.
+  typedef typename vector<value_type>::const_iterator const_iterator;
+
+private:
+  /// The keys of the rows.
+  vector<K> keys;
+
+  /// The elements of row r are from starts[r] to (starts[r + 1] - 1).
+  vector<size_t> starts;
+
+  /// The elements of all rows.
+  vector<value_type> elems;
+
+  /// Compares the key of a row with a key.
+  static bool key_less(const K &k1, const K &k2)
+  {
+    return k1 < k2;
+  }
+
+  /// Compares the column of an element with a key.
+  static bool col_less(const value_type &e, const K &k)
+  {
+    return e.first < k;
+  }
+
+  /**
+   * Returns the element (i, j), or elems.end() if there is no such
+   * element.
+   */
+  const_iterator find(K i, K j) const
+  {
+    typename vector<K>::const_iterator ri =
+      lower_bound(keys.begin(), keys.end(), i, key_less);
+
+    if (ri == keys.end() || *ri != i)
+      return elems.end();
+
+    size_t r = ri - keys.begin();
+    const_iterator e = end(r);
+    const_iterator ji = lower_bound(begin(r), e, j, col_less);
+
+    return ji != e && ji->first == j ? ji : elems.end();
+  }
+
+public:
+  csr_matrix()
+  {
+    starts.push_back(0);
+  }
+
+  /**
+   * Freezes the sparse matrix m.
+   */
+  explicit csr_matrix(const sparse_matrix<K, T> &m)
+  {
+    keys.reserve(m.size());
+    starts.reserve(m.size() + 1);
+    starts.push_back(0);
+
+    for(typename sparse_matrix<K, T>::const_iterator
+          i = m.begin(); i != m.end(); ++i)
+      if (!i->second.empty())
+        {
+          keys.push_back(i->first);
+          elems.insert(elems.end(), i->second.begin(), i->second.end());
+          starts.push_back(elems.size());
+        }
+  }
+
+  /// Returns the number of rows.
+  size_t rows() const
+  {
+    return keys.size();
+  }
+
+  /// Returns the key of row r.
+  K key(size_t r) const
+  {
+    return keys[r];
+  }
+
+  /// Returns the first element of row r.
+  const_iterator begin(size_t r) const
+  {
+    return elems.begin() + starts[r];
+  }
+
+  /// Returns the end of the elements of row r.
+  const_iterator end(size_t r) const
+  {
+    return elems.begin() + starts[r + 1];
+  }
+
+  /// Returns the number of elements.
+  size_t size() const
+  {
+    return elems.size();
+  }
+
+  /// Returns true if the matrix has no elements.
+  bool empty() const
+  {
+    return elems.empty();
+  }
+
+  /**
+   * This function returns the value of an element.  Make sure you can
+   * call this function with function "exists," otherwise this
+   * function could fail with an assertion.
+   */
+  const T &at(K i, K j) const
+  {
+    const_iterator ji = find(i, j);
+    assert(ji != elems.end());
+    return ji->second;
+  }
+
+  /**
+   * Returns true if the element exists or false otherwise.
+   */
+  bool exists(K i, K j) const
+  {
+    return find(i, j) != elems.end();
+  }
+};
+
+#endif /* CSR_MATRIX_HPP */
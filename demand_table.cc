@@ -0,0 +1,179 @@
+#include "demand_table.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+/**
+ * The number of uniform numbers drawn at once for the destinations.
+ */
+static const int draw_size = 64;
+
+demand_table::demand_table(const Graph &g, const fp_matrix &tm) :
+  sources(num_vertices(g))
+{
+  // The rates of the demands of the sources.
+  vector<vector<double> > rates(num_vertices(g));
+
+  for(int i = 0; i < sources.size(); ++i)
+    sources[i].rate = 0;
+
+  // Element tm[i][j] is the rate of the demand from node j to node i.
+  FOREACH_MATRIX_ELEMENT(tm, i, j, rate, fp_matrix)
+    if (rate)
+      {
+        sources[j].rate += rate;
+        sources[j].dsts.push_back(i);
+        rates[j].push_back(rate);
+      }
+
+  for(int j = 0; j < sources.size(); ++j)
+    if (rates[j].size() > 1)
+      build_alias(sources[j], rates[j]);
+}
+
+void
+demand_table::build_alias(source &s, const vector<double> &rates)
+{
+  int n = rates.size();
+
+  s.prob.resize(n);
+  s.alias.resize(n);
+
+  // The probabilities scaled so that their mean is 1.
+  vector<double> p(n);
+  for(int k = 0; k < n; ++k)
+    p[k] = rates[k] * n / s.rate;
+
+  vector<int> small, large;
+  for(int k = 0; k < n; ++k)
+    (p[k] < 1 ? small : large).push_back(k);
+
+  // Every small column is filled up with a large one.
+  while(!small.empty() && !large.empty())
+    {
+      int l = small.back();
+      small.pop_back();
+      int h = large.back();
+
+      s.prob[l] = p[l];
+      s.alias[l] = h;
+
+      p[h] -= 1 - p[l];
+      if (p[h] < 1)
+        {
+          large.pop_back();
+          small.push_back(h);
+        }
+    }
+
+  // The columns left are full, up to the rounding errors.
+  for(int k = 0; k < large.size(); ++k)
+    {
+      s.prob[large[k]] = 1;
+      s.alias[large[k]] = large[k];
+    }
+
+  for(int k = 0; k < small.size(); ++k)
+    {
+      s.prob[small[k]] = 1;
+      s.alias[small[k]] = small[k];
+    }
+}
+
+double
+demand_table::rate(Vertex j) const
+{
+  assert(j < sources.size());
+
+  return sources[j].rate;
+}
+
+void
+demand_table::generate(Vertex j, timeslot ts, slot_pkts &pkts,
+                       stream_rng &rng, packet_pool &pool) const
+{
+  assert(j < sources.size());
+
+  const source &s = sources[j];
+
+  if (s.dsts.empty())
+    return;
+
+  // This is the number of packets that ask for admission at node j
+  // in this time slot, for all destinations.
+  place(j, ts, rng.poisson(s.rate), pkts, rng, pool);
+}
+
+timeslot
+demand_table::next_active(Vertex j, timeslot ts, stream_rng &rng) const
+{
+  assert(j < sources.size());
+
+  const source &s = sources[j];
+
+  if (s.dsts.empty())
+    return never;
+
+  // The number of the time slots without packets, drawn by inversion
+  // of the geometric distribution with the probability of success
+  // 1 - exp(-rate).
+  double gap = floor(log1p(-rng.uniform()) / -s.rate);
+
+  if (gap >= never - ts)
+    return never;
+
+  return ts + timeslot(gap);
+}
+
+void
+demand_table::generate_active(Vertex j, timeslot ts, slot_pkts &pkts,
+                              stream_rng &rng, packet_pool &pool) const
+{
+  assert(j < sources.size());
+
+  const source &s = sources[j];
+
+  assert(!s.dsts.empty());
+
+  place(j, ts, rng.poisson_positive(s.rate), pkts, rng, pool);
+}
+
+void
+demand_table::place(Vertex j, timeslot ts, int number, slot_pkts &pkts,
+                    stream_rng &rng, packet_pool &pool) const
+{
+  const source &s = sources[j];
+
+  pkts.reserve(pkts.size() + number);
+
+  if (s.prob.empty())
+    {
+      while(number--)
+        pkts.push_back(pool.alloc(j, s.dsts[0], ts));
+      return;
+    }
+
+  // The destinations are drawn with one uniform number each: its
+  // integer part selects the column of the alias table, and its
+  // fractional part decides between the column and its alias.
+  int n = s.dsts.size();
+  double u[draw_size];
+
+  while(number)
+    {
+      int m = min(number, draw_size);
+      rng.uniform(u, m);
+
+      for(int k = 0; k < m; ++k)
+        {
+          double x = u[k] * n;
+          int c = int(x);
+          int d = x - c < s.prob[c] ? c : s.alias[c];
+          pkts.push_back(pool.alloc(j, s.dsts[d], ts));
+        }
+
+      number -= m;
+    }
+}
@@ -0,0 +1,125 @@
+#ifndef DEMAND_TABLE_HPP
+#define DEMAND_TABLE_HPP
+
+#include "config.hpp"
+#include "graph.hpp"
+#include "matrixes.hpp"
+#include "packet.hpp"
+#include "packet_pool.hpp"
+#include "rand.hpp"
+
+#include <climits>
+#include <vector>
+
+using namespace std;
+
+/**
+ * The demands of the traffic matrix compiled per source node, for
+ * generating the packets in the simulation.
+ *
+ * The packets of the demands of a source node are the superposition
+ * of the Poisson processes of the demands, and so their number is
+ * drawn at once from the Poisson distribution with the aggregate
+ * rate.  Then every packet draws its destination with the
+ * probability proportional to the rate of the demand, with the alias
+ * table of the source node.  The packets are distributed the same as
+ * if they were drawn for every demand separately, but the cost of a
+ * time slot depends on the number of demands, not on the square of
+ * the number of nodes.
+ *
+ * The table is built once, and then only read, and so it can be
+ * shared by threads.
+ */
+class demand_table
+{
+  /// The demands of a source node.
+  struct source
+  {
+    /// The aggregate rate of the demands.
+    double rate;
+
+    /// The destination nodes of the demands.
+    vector<Vertex> dsts;
+
+    /**
+     * The alias table of the destinations of Walker: the k-th
+     * destination is drawn with probability prob[k], and otherwise
+     * the destination alias[k] is drawn.
+     */
+    vector<double> prob;
+    vector<int> alias;
+  };
+
+  /// The sources indexed by vertex.
+  vector<source> sources;
+
+  /**
+   * Builds the alias table of source s with Vose's method.
+   */
+  static void
+  build_alias(source &s, const vector<double> &rates);
+
+  /**
+   * Appends the given number of packets of source node j for time
+   * slot ts, with their destinations drawn from the alias table.
+   */
+  void
+  place(Vertex j, timeslot ts, int number, slot_pkts &pkts,
+        stream_rng &rng, packet_pool &pool) const;
+
+public:
+  /// The time slot that never comes.
+  static const timeslot never = LONG_MAX;
+
+  /**
+   * Compiles the demands of traffic matrix tm.
+   */
+  demand_table(const Graph &g, const fp_matrix &tm);
+
+  /**
+   * Returns the aggregate rate of the demands of source node j.
+   */
+  double
+  rate(Vertex j) const;
+
+  /**
+   * Generates the packets of the demands of source node j for time
+   * slot ts, and appends them to pkts.
+   *
+   * @param rng the generation stream of node j for time slot ts
+   *
+   * @param pool the pool to take packets from
+   */
+  void
+  generate(Vertex j, timeslot ts, slot_pkts &pkts, stream_rng &rng,
+           packet_pool &pool) const;
+
+  /**
+   * Returns the first time slot from ts on in which source node j
+   * generates packets, or never.  A time slot has packets with
+   * probability 1 - exp(-rate) independently of the others, and so
+   * the number of the time slots without packets is drawn at once
+   * from the geometric distribution.
+   *
+   * @param rng the gap stream of node j for time slot ts
+   */
+  timeslot
+  next_active(Vertex j, timeslot ts, stream_rng &rng) const;
+
+  /**
+   * Generates the packets of source node j for time slot ts, which
+   * is known to have packets, i.e., it was returned by next_active.
+   * The number of packets is drawn from the Poisson distribution
+   * conditioned on being positive, and so the packets are
+   * distributed the same as with generate.
+   *
+   * @param rng the generation stream of node j for time slot ts
+   *
+   * @param pool the pool to take packets from
+   */
+  void
+  generate_active(Vertex j, timeslot ts, slot_pkts &pkts, stream_rng &rng,
+                  packet_pool &pool) const;
+};
+
+#endif /* DEMAND_TABLE_HPP */
@@ -1,4 +1,5 @@
 #include "distro.hpp"
+#include "geometric.hpp"
 #include "nodistro.hpp"
 #include "poisson.hpp"
 #include "tabdistro.hpp"
@@ -6,29 +7,36 @@
 #include <cassert>
 #include <string>
 
+void
+distro::construct(const distro_base &db)
+{
+  if (const nodistro *d = dynamic_cast<const nodistro *>(&db))
+    construct(*d);
+  else if (const poisson *d = dynamic_cast<const poisson *>(&db))
+    construct(*d);
+  else if (const geometric *d = dynamic_cast<const geometric *>(&db))
+    construct(*d);
+  else if (const tabdistro *d = dynamic_cast<const tabdistro *>(&db))
+    construct(*d);
+  else
+    assert(false);
+}
+
 distro &
 distro::operator += (const distro &d)
 {
-  nodistro *this_nodistro = dynamic_cast<nodistro *>(db);
-  poisson *this_poisson = dynamic_cast<poisson *>(db);
-  tabdistro *this_tabdistro = dynamic_cast<tabdistro *>(db);
-  assert(this_nodistro || this_poisson || this_tabdistro);
-
-  nodistro *d_nodistro = dynamic_cast<nodistro *>(d.db);
-  poisson *d_poisson = dynamic_cast<poisson *>(d.db);
-  tabdistro *d_tabdistro = dynamic_cast<tabdistro *>(d.db);
-  assert(d_nodistro || d_poisson || d_tabdistro);
+  assert(kind != GEOMETRIC && d.kind != GEOMETRIC);
 
-  if (this_poisson && d_poisson)
-    this->operator=(poisson(db->mean() + d.db->mean()));
-  else if (this_tabdistro && d_tabdistro)
-    (*this_tabdistro) += (*d_tabdistro);
-  else if (this_nodistro && !d_nodistro)
+  if (kind == POISSON && d.kind == POISSON)
+    as<poisson>() = poisson(mean() + d.mean());
+  else if (kind == TABDISTRO && d.kind == TABDISTRO)
+    (*store.td) += (*d.store.td);
+  else if (kind == NODISTRO && d.kind != NODISTRO)
     this->operator=(d);
-  else if (d_nodistro)
+  else if (d.kind == NODISTRO)
     {} // do nothing
   else
-    assert(this_nodistro && d_nodistro);
+    assert(kind == NODISTRO && d.kind == NODISTRO);
 
   return *this;
 }
@@ -36,39 +44,31 @@ distro::operator += (const distro &d)
 distro &
 distro::operator *= (double p)
 {
-  nodistro *this_nodistro = dynamic_cast<nodistro *>(db);
-  poisson *this_poisson = dynamic_cast<poisson *>(db);
-  tabdistro *this_tabdistro = dynamic_cast<tabdistro *>(db);
-  assert(this_nodistro || this_poisson);
-  assert(!this_tabdistro);
+  assert(kind == NODISTRO || kind == POISSON);
+
+  if (kind == POISSON)
+    as<poisson>() = poisson(p * mean());
 
-  if (this_poisson)
-    operator = (distro(poisson(p * mean())));
+  return *this;
 }
 
 bool
 distro::operator == (const distro &d) const
 {
-  nodistro *this_nodistro = dynamic_cast<nodistro *>(db);
-  poisson *this_poisson = dynamic_cast<poisson *>(db);
-  tabdistro *this_tabdistro = dynamic_cast<tabdistro *>(db);
-  assert(this_nodistro || this_poisson || this_tabdistro);
-
-  nodistro *d_nodistro = dynamic_cast<nodistro *>(d.db);
-  poisson *d_poisson = dynamic_cast<poisson *>(d.db);
-  tabdistro *d_tabdistro = dynamic_cast<tabdistro *>(d.db);
-  assert(d_nodistro || d_poisson || d_tabdistro);
-
-  if (this_nodistro && d_nodistro)
-    return *this_nodistro == *d_nodistro;
-
-  if (this_poisson && d_poisson)
-    return *this_poisson == *d_poisson;
-
-  if (this_tabdistro && d_tabdistro)
-    return *this_tabdistro == *d_tabdistro;
+  if (kind != d.kind)
+    return false;
 
-  return false;
+  switch(kind)
+    {
+    case NODISTRO:
+      return as<nodistro>() == d.as<nodistro>();
+    case POISSON:
+      return as<poisson>() == d.as<poisson>();
+    case GEOMETRIC:
+      return as<geometric>() == d.as<geometric>();
+    default:
+      return *store.td == *d.store.td;
+    }
 }
 
 distro
@@ -82,6 +82,6 @@ operator * (double p, const distro &d)
 ostream &
 operator << (ostream &out, const distro &d)
 {
-  d.db->output(out);
+  d.base().output(out);
   return out;
 }
@@ -3,20 +3,41 @@
 
 #include "counter.hpp"
 #include "distro_base.hpp"
+#include "geometric.hpp"
 #include "nodistro.hpp"
+#include "poisson.hpp"
 #include "tabdistro.hpp"
 
+#include <cstddef>
 #include <iostream>
+#include <new>
 #include <string>
 #include <utility>
 
 #include <boost/serialization/access.hpp>
+#include <boost/serialization/split_member.hpp>
 
 using namespace std;
 
+/**
+ * The larger of the two sizes.
+ */
+template<size_t A, size_t B>
+struct max_size
+{
+  static const size_t value = A > B ? A : B;
+};
+
 /**
  * The envelope class for probability distributions.
  *
+ * It's a tagged union: nodistro, poisson and geometric are kept in
+ * place, and only tabdistro, which can be large, is kept on the
+ * heap.  The kind of the distribution is known from the tag, and so
+ * the frequently used functions call the functions of the
+ * distributions directly, not through the virtual functions, and the
+ * operators don't need dynamic_cast.
+ *
  * We define it all inline to make it faster, because it's small and
  * frequently used.
  */
@@ -25,24 +46,161 @@ class distro : private counter<distro>
   friend class boost::serialization::access;
   friend ostream &operator << (ostream &o, const distro &b);
 
+  /// The kinds of distributions.
+  enum kind_t {NODISTRO, POISSON, GEOMETRIC, TABDISTRO};
+
+  /// The kind of the distribution kept.
+  kind_t kind;
+
+  /// The size of the storage for the distributions kept in place.
+  static const size_t buf_size =
+    max_size<sizeof(nodistro),
+             max_size<sizeof(poisson), sizeof(geometric)>::value>::value;
+
+  /**
+   * The storage of the distribution.  The double and the void
+   * pointer are there to align the buffer.
+   */
+  union
+  {
+    char buf[buf_size];
+    tabdistro *td;
+    double align_d;
+    void *align_p;
+  } store;
+
+  template<typename T>
+  T &as()
+  {
+    return *reinterpret_cast<T *>(store.buf);
+  }
+
+  template<typename T>
+  const T &as() const
+  {
+    return *reinterpret_cast<const T *>(store.buf);
+  }
+
+  /**
+   * Returns the distribution kept.
+   */
+  const distro_base &base() const
+  {
+    switch(kind)
+      {
+      case NODISTRO:
+        return as<nodistro>();
+      case POISSON:
+        return as<poisson>();
+      case GEOMETRIC:
+        return as<geometric>();
+      default:
+        return *store.td;
+      }
+  }
+
+  void construct(const nodistro &d)
+  {
+    new (store.buf) nodistro(d);
+    kind = NODISTRO;
+  }
+
+  void construct(const poisson &d)
+  {
+    new (store.buf) poisson(d);
+    kind = POISSON;
+  }
+
+  void construct(const geometric &d)
+  {
+    new (store.buf) geometric(d);
+    kind = GEOMETRIC;
+  }
+
+  void construct(const tabdistro &d)
+  {
+    store.td = new tabdistro(d);
+    kind = TABDISTRO;
+  }
+
+  /**
+   * Constructs the distribution of the dynamic type of db.
+   */
+  void construct(const distro_base &db);
+
+  /**
+   * Constructs the copy of the distribution of d.
+   */
+  void construct_copy(const distro &d)
+  {
+    switch(d.kind)
+      {
+      case NODISTRO:
+        construct(d.as<nodistro>());
+        break;
+      case POISSON:
+        construct(d.as<poisson>());
+        break;
+      case GEOMETRIC:
+        construct(d.as<geometric>());
+        break;
+      default:
+        construct(*d.store.td);
+      }
+  }
+
   /**
-   * Pointer to the implementation.
+   * Destroys the distribution kept.
    */
-  distro_base *db;
+  void destroy()
+  {
+    switch(kind)
+      {
+      case NODISTRO:
+        as<nodistro>().~nodistro();
+        break;
+      case POISSON:
+        as<poisson>().~poisson();
+        break;
+      case GEOMETRIC:
+        as<geometric>().~geometric();
+        break;
+      default:
+        delete store.td;
+      }
+  }
 
+  /**
+   * We save the distribution through a pointer to distro_base, and
+   * so the archives are the same as when the distribution was kept
+   * on the heap.
+   */
   template<class Archive>
-  void serialize(Archive &ar, const unsigned int version)
+  void save(Archive &ar, const unsigned int version) const
   {
+    distro_base *db = const_cast<distro_base *>(&base());
     ar & db;
   }
 
+  template<class Archive>
+  void load(Archive &ar, const unsigned int version)
+  {
+    distro_base *db = 0;
+    ar & db;
+    destroy();
+    construct(*db);
+    delete db;
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
 public:
   /**
    * The default constructor created a nodistro object.
    */
   distro()
   {
-    db = new nodistro();
+    construct(nodistro());
   }
 
   /**
@@ -50,11 +208,31 @@ public:
    * distribution is copied, and you should make sure that you destroy
    * it.
    *
-   * @param db the distribution
+   * @param d the distribution
    */
+  distro(const nodistro &d)
+  {
+    construct(d);
+  }
+
+  distro(const poisson &d)
+  {
+    construct(d);
+  }
+
+  distro(const geometric &d)
+  {
+    construct(d);
+  }
+
+  distro(const tabdistro &d)
+  {
+    construct(d);
+  }
+
   distro(const distro_base &db)
   {
-    distro::db = db.clone();
+    construct(db);
   }
 
   /**
@@ -62,23 +240,26 @@ public:
    */
   distro(const distro &d)
   {
-    distro::db = d.db->clone();
+    construct_copy(d);
   }
 
   ~distro()
   {
-    delete db;
+    destroy();
   }
 
   /**
    * The assignment operator destroys the object currently stored, and
-   * clones the right-hand side object for itself.
+   * copies the right-hand side object for itself.
    */
   distro& operator=(const distro &d)
   {
-    distro_base *new_db = d.db->clone();
-    delete db;
-    db = new_db;
+    if (this != &d)
+      {
+        destroy();
+        construct_copy(d);
+      }
+
     return *this;
   }
 
@@ -90,9 +271,19 @@ public:
    *
    * @return true if the i-th most probable value exists
    */
-  bool exists_ith_max(int i)
+  bool exists_ith_max(int i) const
   {
-    return db->exists_ith_max(i);
+    switch(kind)
+      {
+      case NODISTRO:
+        return as<nodistro>().nodistro::exists_ith_max(i);
+      case POISSON:
+        return as<poisson>().poisson::exists_ith_max(i);
+      case GEOMETRIC:
+        return as<geometric>().geometric::exists_ith_max(i);
+      default:
+        return store.td->tabdistro::exists_ith_max(i);
+      }
   }
 
   /**
@@ -103,9 +294,19 @@ public:
    *
    * @param i the number of the i-th most probable value
    */
-  prob_pair get_ith_max(int i)
+  prob_pair get_ith_max(int i) const
   {
-    return db->get_ith_max(i);
+    switch(kind)
+      {
+      case NODISTRO:
+        return as<nodistro>().nodistro::get_ith_max(i);
+      case POISSON:
+        return as<poisson>().poisson::get_ith_max(i);
+      case GEOMETRIC:
+        return as<geometric>().geometric::get_ith_max(i);
+      default:
+        return store.td->tabdistro::get_ith_max(i);
+      }
   }
 
   /**
@@ -116,9 +317,19 @@ public:
    *
    * @return the probability for this value
    */
-  double get_prob(int i)
+  double get_prob(int i) const
   {
-    return db->get_prob(i);
+    switch(kind)
+      {
+      case NODISTRO:
+        return as<nodistro>().nodistro::get_prob(i);
+      case POISSON:
+        return as<poisson>().poisson::get_prob(i);
+      case GEOMETRIC:
+        return as<geometric>().geometric::get_prob(i);
+      default:
+        return store.td->tabdistro::get_prob(i);
+      }
   }
 
   /**
@@ -129,7 +340,7 @@ public:
    */
   string to_tabular() const
   {
-    return db->to_tabular();
+    return base().to_tabular();
   }
 
   /**
@@ -137,7 +348,17 @@ public:
    */
   double mean() const
   {
-    return db->mean();
+    switch(kind)
+      {
+      case NODISTRO:
+        return as<nodistro>().nodistro::mean();
+      case POISSON:
+        return as<poisson>().poisson::mean();
+      case GEOMETRIC:
+        return as<geometric>().geometric::mean();
+      default:
+        return store.td->tabdistro::mean();
+      }
   }
 
   /**
@@ -146,7 +367,25 @@ public:
   bool
   is_nodistro() const
   {
-    return dynamic_cast<nodistro *>(db) != NULL;
+    return kind == NODISTRO;
+  }
+
+  /**
+   * Returns true if the distribution is poisson.
+   */
+  bool
+  is_poisson() const
+  {
+    return kind == POISSON;
+  }
+
+  /**
+   * Returns true if the distribution is geometric.
+   */
+  bool
+  is_geometric() const
+  {
+    return kind == GEOMETRIC;
   }
 
   /**
@@ -155,7 +394,7 @@ public:
   bool
   is_tabdistro() const
   {
-    return dynamic_cast<tabdistro *>(db) != NULL;
+    return kind == TABDISTRO;
   }
 
   /**
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include "graph.hpp"
 #include "edge_probs.hpp"
 #include "utils.hpp"
@@ -26,6 +28,29 @@ operator += (edge_probs &v1, const edge_probs &v2)
 {
   for(edge_probs::const_iterator i = v2.begin(); i != v2.end(); ++i)
     v1[i->first] += i->second;
+
+  return v1;
+}
+
+double
+max_diff(const edge_probs &v1, const edge_probs &v2)
+{
+  double result = 0;
+
+  // The edges of v1, which may be missing in v2.
+  for(edge_probs::const_iterator i = v1.begin(); i != v1.end(); ++i)
+    {
+      edge_probs::const_iterator j = v2.find(i->first);
+      double p2 = j == v2.end() ? 0 : j->second;
+      result = max(result, fabs(i->second - p2));
+    }
+
+  // The edges of v2 missing in v1.
+  for(edge_probs::const_iterator i = v2.begin(); i != v2.end(); ++i)
+    if (v1.find(i->first) == v1.end())
+      result = max(result, fabs(i->second));
+
+  return result;
 }
 
 edge_probs_map &
@@ -51,6 +76,8 @@ operator += (edge_count &v1, const edge_count &v2)
 {
   for(edge_count::const_iterator i = v2.begin(); i != v2.end(); ++i)
     v1[i->first] += i->second;
+
+  return v1;
 }
 
 edge_count_map &
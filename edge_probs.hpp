@@ -83,6 +83,13 @@ operator += (edge_count &v1, const edge_count &v2);
 edge_count_map &
 operator += (edge_count_map &v1, const edge_count_map &v2);
 
+/**
+ * Returns the largest absolute difference between the probabilities
+ * of v1 and v2.  The probability of an edge that is missing is zero.
+ */
+double
+max_diff(const edge_probs &v1, const edge_probs &v2);
+
 /**
  * Print the edge_probs to the stream.
  */
@@ -4,6 +4,7 @@
 #include "matrixes.hpp"
 #include "distro.hpp"
 #include "nodistro.hpp"
+#include "parallel.hpp"
 #include "poisson.hpp"
 #include "utils.hpp"
 #include "utils_ana.hpp"
@@ -11,6 +12,7 @@
 #include <cassert>
 #include <iostream>
 #include <map>
+#include <vector>
 
 #include <boost/foreach.hpp>
 
@@ -52,60 +54,93 @@ generate_itm(const Graph &g, const pt_matrix &ptm, fp_matrix &itm)
 }
 
 
+/**
+ * Calculates the admission rates of a node.  The rates of node j are
+ * put into rates[j], so that the nodes can be processed concurrently.
+ */
+class atm_task
+{
+  const Graph &g;
+  const fp_matrix &tm;
+  const fp_matrix &itm;
+
+public:
+  /// The mapping between the vertex and a floating point value.
+  typedef map<Vertex, double> ver2fp;
+
+  /// The admission rates of the nodes.
+  vector<ver2fp> rates;
+
+  atm_task(const Graph &g, const fp_matrix &tm, const fp_matrix &itm) :
+    g(g), tm(tm), itm(itm), rates(num_vertices(g))
+  {
+  }
+
+  /// Processes source node j.
+  void operator()(int j)
+  {
+    // This is the total transit traffic rate at node j.  Here we add
+    // rates of all demands that arrive at node j, except the demand
+    // for which node j is the destination.
+    double alpha_prime = 0;
+    BGL_FORALL_VERTICES(i, g, Graph)
+      if (i != j && itm.exists(i, j))
+        {
+          double rate = itm.at(i, j);
+          assert(rate != 0);
+          alpha_prime += rate;
+        }
+
+    // Get the output capacity of node j.
+    int v = get_output_capacity(g, j);
+
+    // These are the demands for destination nodes.  i is the
+    // destination node.
+    ver2fp beta;
+    BGL_FORALL_VERTICES(i, g, Graph)
+      if (tm.exists(i, j))
+        {
+          double rate = tm.at(i, j);
+          assert(rate != 0);
+          beta[i] = rate;
+        }
+
+    // We know that at node j the number of packets in transit is
+    // alpha_prime, the output capacity is v, and the average numbers
+    // of packets asking admission are given by beta.
+    distro apd;
+    if (alpha_prime != 0)
+      apd = poisson(alpha_prime);
+
+    rates[j] = admit_ana(apd, v, beta);
+  }
+};
+
 void
 generate_atm(const Graph &g, const fp_matrix &tm,
              const fp_matrix &itm, fp_matrix &atm)
+{
+  generate_atm(g, tm, itm, atm, 1);
+}
+
+void
+generate_atm(const Graph &g, const fp_matrix &tm,
+             const fp_matrix &itm, fp_matrix &atm, int threads)
 {
   // We want an empty atm matrix.
   assert(atm.empty());
 
   // Calculate admission rates for each source node j.
+  atm_task task(g, tm, itm);
+  parallel_for(num_vertices(g), threads, task);
+
+  // Put the rates into the matrix in the order of the nodes.
   BGL_FORALL_VERTICES(j, g, Graph)
-    {
-      // This is the total transit traffic rate at node j.  Here we
-      // add rates of all demands that arrive at node j, except the
-      // demand for which node j is the destination.
-      double alpha_prime = 0;
-      BGL_FORALL_VERTICES(i, g, Graph)
-        if (i != j && itm.exists(i, j))
-          {
-            double rate = itm.at(i, j);
-            assert(rate != 0);
-            alpha_prime += rate;
-          }
-
-      // Get the output capacity of node j.
-      int v = get_output_capacity(g, j);
-
-      // The mapping between the vertex and a floating point value.
-      typedef map<Vertex, double> ver2fp;
-
-      // These are the demands for destination nodes.  i is the
-      // destination node.
-      ver2fp beta;
-      BGL_FORALL_VERTICES(i, g, Graph)
-        if (tm.exists(i, j))
-          {
-            double rate = tm.at(i, j);
-            assert(rate != 0);
-            beta[i] = rate;
-          }
-
-      // We know that at node j the number of packets in transit is
-      // alpha_prime, the output capacity is v, and the average
-      // numbers of packets asking admission are given by beta.
-      distro apd;
-      if (alpha_prime != 0)
-        apd = poisson(alpha_prime);
-
-      ver2fp beta_prime = admit_ana(apd, v, beta);
-
-      BOOST_FOREACH(ver2fp::value_type &ii, beta_prime)
-        // Make sure the admission rate is not zero.
-        if (ii.second != 0)
-          // ii.first is the destination node of the demand.
-          atm[ii.first][j] = ii.second;
-    }
+    BOOST_FOREACH(atm_task::ver2fp::value_type &ii, task.rates[j])
+      // Make sure the admission rate is not zero.
+      if (ii.second != 0)
+        // ii.first is the destination node of the demand.
+        atm[ii.first][j] = ii.second;
 }
 
 
@@ -135,36 +170,95 @@ generate_otm(const fp_matrix &itm, const fp_matrix &atm, fp_matrix &otm)
 }
 
 
+/**
+ * Calculates the routing probabilities of a node.  The probabilities
+ * of node j are put into probs[j], so that the nodes can be processed
+ * concurrently.
+ */
+class epm_task
+{
+  const Graph &g;
+  const fp_matrix &otm;
+
+  /// The routing caches of the nodes, or null if there are none.
+  vector<route_cache> *caches;
+
+public:
+  /// The routing probabilities of the nodes.
+  vector<edge_probs_map> probs;
+
+  epm_task(const Graph &g, const fp_matrix &otm,
+           vector<route_cache> *caches) :
+    g(g), otm(otm), caches(caches), probs(num_vertices(g))
+  {
+  }
+
+  /// Processes node j.
+  void operator()(int j)
+  {
+    map<Vertex, distro> input;
+
+    // Get the rate of packets that go to node i.
+    BGL_FORALL_VERTICES(i, g, Graph)
+      if (otm.exists(i, j))
+        {
+          // We assert that there are no packets that want to leave
+          // node j to get back to the very same node j.
+          assert(i != j);
+          double rate = otm.at(i, j);
+          assert(rate != 0);
+          input[i] = poisson(rate);
+        }
+
+    // Node j is processed by one thread, and so is its cache.
+    if (caches)
+      route_ana(g, j, input, probs[j], (*caches)[j]);
+    else
+      route_ana(g, j, input, probs[j]);
+  }
+};
+
 void
 generate_epm(const Graph &g, const fp_matrix &otm, edge_probs_matrix &epm)
+{
+  generate_epm(g, otm, epm, 1);
+}
+
+/**
+ * Generates the edge probability matrix with the routing caches, or
+ * without them if caches is null.
+ */
+static void
+generate_epm(const Graph &g, const fp_matrix &otm, edge_probs_matrix &epm,
+             int threads, vector<route_cache> *caches)
 {
   // We want an empty epm matrix.
   assert(epm.empty());
 
   // For every node j, calculate the routing probabilities.
+  epm_task task(g, otm, caches);
+  parallel_for(num_vertices(g), threads, task);
+
+  // Put the probabilities into the matrix in the order of the nodes.
   BGL_FORALL_VERTICES(j, g, Graph)
-    {
-      map<Vertex, distro> input;
-
-      // Get the rate of packets that go to node i.
-      BGL_FORALL_VERTICES(i, g, Graph)
-        if (otm.exists(i, j))
-          {
-            // We assert that there are no packets that want to
-            // leave node j to get back to the very same node j.
-            assert(i != j);
-            double rate = otm.at(i, j);
-            assert(rate != 0);
-            input[i] = poisson(rate);
-          }
-
-      edge_probs_map probs;
-      route_ana(g, j, input, probs);
-
-      for(edge_probs_map::const_iterator
-            i = probs.begin(); i != probs.end(); ++i)
-        epm[i->first][j] = i->second;
-    }
+    for(edge_probs_map::const_iterator
+          i = task.probs[j].begin(); i != task.probs[j].end(); ++i)
+      epm[i->first][j] = i->second;
+}
+
+void
+generate_epm(const Graph &g, const fp_matrix &otm, edge_probs_matrix &epm,
+             int threads)
+{
+  generate_epm(g, otm, epm, threads, 0);
+}
+
+void
+generate_epm(const Graph &g, const fp_matrix &otm, edge_probs_matrix &epm,
+             int threads, vector<route_cache> &caches)
+{
+  assert(caches.size() == num_vertices(g));
+  generate_epm(g, otm, epm, threads, &caches);
 }
 
 
@@ -5,6 +5,9 @@
 #include "graph.hpp"
 #include "matrixes.hpp"
 #include "packet.hpp"
+#include "route_cache.hpp"
+
+#include <vector>
 
 /**
  * Generates the input traffic matrix, which is returned as the itm
@@ -56,6 +59,15 @@ void
 generate_atm(const Graph &g, const fp_matrix &tm,
 	     const fp_matrix &itm, fp_matrix &atm);
 
+/**
+ * Generates the admitted traffic matrix atm with the given number of
+ * threads.  The nodes are processed concurrently, and the results
+ * don't depend on the number of threads.
+ */
+void
+generate_atm(const Graph &g, const fp_matrix &tm,
+	     const fp_matrix &itm, fp_matrix &atm, int threads);
+
 /**
  * Generates the output traffic matrix otm based on the input traffic
  * matrix itm and the admitted traffic matrix atm.
@@ -93,6 +105,24 @@ generate_otm(const fp_matrix &itm, const fp_matrix &atm, fp_matrix &otm);
 void
 generate_epm(const Graph &g, const fp_matrix &otm, edge_probs_matrix &epm);
 
+/**
+ * Generates the edge probability matrix epm with the given number of
+ * threads.  The nodes are processed concurrently, and the results
+ * don't depend on the number of threads.
+ */
+void
+generate_epm(const Graph &g, const fp_matrix &otm, edge_probs_matrix &epm,
+             int threads);
+
+/**
+ * Generates the edge probability matrix epm with the given number of
+ * threads, and with the routing results of node j cached in
+ * caches[j].  The caches should be kept across the iterations.
+ */
+void
+generate_epm(const Graph &g, const fp_matrix &otm, edge_probs_matrix &epm,
+             int threads, vector<route_cache> &caches);
+
 /**
  * Here we create the transition matrix for packets which go to the
  * dest node.  We generate it based on the graph g and edge
@@ -46,9 +46,10 @@ geometric::get_ith_max(int i) const
 double
 geometric::get_prob(int i) const
 {
-  assert(i >= 1);
+  assert(i >= 0);
 
-  return gsl_ran_geometric_pdf(i, p);
+  // The distribution starts at 1, and so there's no 0.
+  return i ? gsl_ran_geometric_pdf(i, p) : 0;
 }
 
 string
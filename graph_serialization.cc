@@ -1,3 +0,0 @@
-#include "graph.hpp"
-
-Graph *p_graph;
@@ -8,24 +8,55 @@
 #include <boost/serialization/split_free.hpp>
 #include <boost/serialization/vector.hpp>
 
-extern Graph *p_graph;
+#include <cassert>
+
+/**
+ * The helper of an archive which tells the graph of the edges that
+ * are serialized.  With it, every archive has its own graph, and so
+ * archives can be used concurrently.  The graph has to be set before
+ * an edge is serialized.
+ *
+ * Example:
+ *
+ * ia.get_helper<graph_helper>().g = &g;
+ */
+struct graph_helper
+{
+  graph_helper() : g(0)
+  {
+  }
+
+  const Graph *g;
+};
 
 namespace boost {
   namespace serialization {
 
+    /**
+     * Returns the graph of the edges serialized with the archive.
+     */
+    template<class A>
+    const Graph &archive_graph(A &ar)
+    {
+      const Graph *g = ar.template get_helper<graph_helper>().g;
+      assert(g);
+      return *g;
+    }
+
     template<class A>
     void load(A &ar, Edge &p, const unsigned int)
     {
       Vertex s, t;
       ar & s & t;
-      p = edge(s, t, *p_graph).first;
+      p = edge(s, t, archive_graph(ar)).first;
     }
 
     template<class A>
     void save(A &ar, const Edge &p, const unsigned int)
     {
-      Vertex s = source(p, *p_graph);
-      Vertex t = target(p, *p_graph);
+      const Graph &g = archive_graph(ar);
+      Vertex s = source(p, g);
+      Vertex t = target(p, g);
       ar & s & t;
     }
 
@@ -1,10 +1,15 @@
 #ifndef MATRIXES_HPP
 #define MATRIXES_HPP
 
+#include "csr_matrix.hpp"
 #include "packet.hpp"
 #include "polynomial.hpp"
 #include "sparse_matrix.hpp"
 
+#include <utility>
+
+#include <boost/cstdint.hpp>
+
 /**
  * Element [i][j] of this matrix stores a packet presence for demand
  * (j, i), where j is the source node and i is the destination node.
@@ -19,12 +24,6 @@ typedef sparse_matrix<Vertex, packet_presence> pp_matrix;
  */
 typedef sparse_matrix<Vertex, packet_presence_count_map> ppcm_matrix;
 
-/**
- * Used in simulation to count the number of packets that arrive at a
- * node in a single time slot.  It's used to build ppcm_matrix.
- */
-typedef sparse_matrix<Vertex, packet_presence_count> ppc_matrix;
-
 /**
  * Element [i][j] of this matrix stores a packet trajectory for demand
  * (j, i), where j is the source node and i is the destination node.
@@ -39,12 +38,6 @@ typedef sparse_matrix<Vertex, packet_trajectory> pt_matrix;
  */
 typedef sparse_matrix<Vertex, packet_trajectory_count_map> ptcm_matrix;
 
-/**
- * Used in simulation to count the number of packets that traverse a
- * link in a single time slot.  It's used to build ptcm_matrix.
- */
-typedef sparse_matrix<Vertex, packet_trajectory_count> ptc_matrix;
-
 /**
  * This is matrix that for every element [i][j] stores a floating
  * point value.
@@ -58,10 +51,24 @@ typedef sparse_matrix<Vertex, packet_trajectory_count> ptc_matrix;
  */
 typedef sparse_matrix<Vertex, double> fp_matrix;
 
+/**
+ * Element [i][j] of this matrix stores the numbers of packets of
+ * demand (j, i) that were admitted and rejected at node j in the
+ * simulation.
+ */
+typedef sparse_matrix<Vertex, std::pair<boost::uint64_t, boost::uint64_t> >
+adm_matrix;
+
 /**
  * This is the type of the transition matrix.  The elements are
  * polynomials with floating point coefficients.
  */
 typedef sparse_matrix<Vertex, fp_poly> trans_matrix;
 
+/**
+ * This is the transition matrix frozen in the compressed sparse row
+ * format once it's generated.  It's used to make hops.
+ */
+typedef csr_matrix<Vertex, fp_poly> csr_trans_matrix;
+
 #endif /* MATRIXES_HPP */
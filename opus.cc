@@ -5,8 +5,8 @@
 #include "matrixes.hpp"
 #include "poisson.hpp"
 #include "serializer.hpp"
-#include "rand.hpp"
 #include "simulation.hpp"
+#include "tabdistro.hpp"
 #include "utils.hpp"
 
 #include <ctime>
@@ -43,21 +43,32 @@ main (int argc, char* argv[])
   // Stores the results: the packet trajectory matrix.
   pt_matrix ptm;
 
+  // The seed of the random number generators for simulation.
+  unsigned long seed = 0;
+
   if (args.touch_random_seed)
     {
       time_t ourTime;
       time(&ourTime);
-      mysrand((unsigned int)ourTime);
+      seed = ourTime;
     }
 
+  // The tail cut off the sums of the tabular distributions.
+  tabdistro::set_epsilon(args.epsilon);
+
   // The serializer for saving results.
   serializer s(args, g, tm);
 
   if (args.method == analysis)
     tie(ppm, ptm) = ana_solution(g, tm, args.HL, args.DL, args.iters,
-                                 args.AL, cerr, s);
+                                 args.AL, args.threads, args.tolerance,
+                                 cerr, s);
   else
-    tie(ppm, ptm) = sim_solution(g, tm, args.HL, args.DL, cerr);
+    tie(ppm, ptm) = sim_solution(g, tm, args.HL, args.DL,
+                                 args.replications, args.threads,
+                                 seed, args.precision, args.max_slots,
+                                 args.events, args.checkpoint,
+                                 args.checkpoint_slots, args.resume, cerr);
 
   // Save the final ptm.
   s(ptm);
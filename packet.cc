@@ -1,6 +1,6 @@
 #include "packet.hpp"
 
-int packet::next_ID = 0;
+boost::detail::atomic_count packet::next_ID(0);
 
 ostream &operator << (ostream &out, const packet_prefs &prefs)
 {
@@ -5,6 +5,7 @@
 #include "graph.hpp"
 #include "polynomial.hpp"
 
+#include <boost/detail/atomic_count.hpp>
 #include <boost/graph/iteration_macros.hpp>
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/base_object.hpp>
@@ -29,13 +30,6 @@ typedef map<int, map<Edge, dist_poly> > packet_trajectory;
  */
 typedef map<int, map<Edge, count_map_poly> > packet_trajectory_count_map;
 
-/**
- * Remembers the number of packets and the distance they travelled in
- * a single time slot.  It's used to build
- * packet_trajectory_count_map.
- */
-typedef map<int, map<Edge, count_poly> > packet_trajectory_count;
-
 /**
  * This describes what nodes packets visit in the subsequent hops.
  * Note that it's for hops, not time slots!
@@ -53,12 +47,6 @@ typedef map<int, map<Vertex, dist_poly> > packet_presence;
  */
 typedef map<int, map<Vertex, count_map_poly> > packet_presence_count_map;
 
-/**
- * Remembers the number of packets that visit node during a single
- * time slot.  It's used to build packet_presence_count_map.
- */
-typedef map<int, map<Vertex, count_poly> > packet_presence_count;
-
 /**
  * The packet structure.  There is a close match between the packet
  * struct and the packet_prefs.
@@ -71,13 +59,14 @@ struct packet
   int ID;
 
   /**
-   * The next available ID for a packet.
+   * The last ID given to a packet.  Packets are created by many
+   * simulation threads, and so the counter is atomic.
    */
-  static int next_ID;
+  static boost::detail::atomic_count next_ID;
 
   packet(Vertex _src, Vertex _dst, timeslot _start_ts) :
     src(_src), dst(_dst), start_ts(_start_ts), next_ts(_start_ts),
-    ID(next_ID++), hops(0) {}
+    ID(++next_ID), hops(0) {}
 
   /**
    * This keeps the number of hops the packet made.
@@ -128,6 +117,20 @@ public:
  */
 typedef multiset<packet *, pkt_next_ts_cmp> waiting_pkts;
 
+/**
+ * This structure stores packets of a single time slot in the order
+ * they were put there.
+ */
+typedef vector<packet *> slot_pkts;
+
+/**
+ * This structure stores the packets that a node sent during a time
+ * slot.  Every packet is paired with the node it was sent to.  The
+ * packets are kept in the order they were sent, because this order
+ * decides the order in which the packets are later processed.
+ */
+typedef vector<pair<Vertex, packet *> > sent_pkts;
+
 /**
  * Stores the preferred output edges of a packet.
  */
@@ -144,6 +147,10 @@ class packet_prefs: public list<Vertex>
   }
 
 public:
+  packet_prefs() : cls(0), rank(0)
+  {
+  }
+
   /**
    * The class of the packet.
    */
@@ -153,6 +160,21 @@ public:
    * The destination of the packet.
    */
   Vertex dest;
+
+  /**
+   * The preferences as the indexes of the out-edges of the current
+   * node, in the order of the out_edges function.  Together with the
+   * rank they are compiled by the complete_graph function, and they
+   * are not serialized.
+   */
+  vector<int> edges;
+
+  /**
+   * The rank of the destination in the routing order of the current
+   * node.  The destinations of larger rank are routed first, and the
+   * destinations which rou_order can't tell apart have the same rank.
+   */
+  int rank;
 };
 
 /**
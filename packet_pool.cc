@@ -0,0 +1,94 @@
+#include "packet_pool.hpp"
+
+#include <new>
+
+packet_pool::packet_pool()
+{
+}
+
+packet_pool::~packet_pool()
+{
+  for(std::vector<void *>::iterator i = chunks.begin();
+      i != chunks.end(); ++i)
+    ::operator delete(*i);
+}
+
+packet *
+packet_pool::alloc(Vertex src, Vertex dst, timeslot start_ts)
+{
+  if (free_pkts.empty())
+    {
+      // Allocate a new chunk, and put its packets on the free list.
+      // We put them in the reverse order, so that we later take them
+      // in the order of addresses.
+      packet *chunk = static_cast<packet *>
+        (::operator new(chunk_size * sizeof(packet)));
+      chunks.push_back(chunk);
+
+      for(int i = chunk_size - 1; i >= 0; --i)
+        free_pkts.push_back(chunk + i);
+    }
+
+  packet *pkt = free_pkts.back();
+  free_pkts.pop_back();
+
+  return new (pkt) packet(src, dst, start_ts);
+}
+
+void
+packet_pool::release(packet *pkt)
+{
+  pkt->~packet();
+  free_pkts.push_back(pkt);
+}
+
+void
+packet_pool::give_spare(std::vector<slot_pkts> &bufs, int self)
+{
+  if (bufs.size() < 2 || free_pkts.size() <= chunk_size)
+    return;
+
+  // The number of packets for every other buffer.
+  int n = (free_pkts.size() - chunk_size) / (bufs.size() - 1);
+
+  for(int d = 0; d < bufs.size(); ++d)
+    if (d != self)
+      {
+        bufs[d].insert(bufs[d].end(), free_pkts.end() - n, free_pkts.end());
+        free_pkts.resize(free_pkts.size() - n);
+      }
+}
+
+void
+packet_pool::take_spare(slot_pkts &buf)
+{
+  free_pkts.insert(free_pkts.end(), buf.begin(), buf.end());
+  buf.clear();
+}
+
+int
+packet_pool::chunk_count() const
+{
+  return chunks.size();
+}
+
+pool_balancer::pool_balancer(int nt) :
+  spare(2, std::vector<std::vector<slot_pkts> >
+        (nt, std::vector<slot_pkts>(nt)))
+{
+}
+
+void
+pool_balancer::give(int w, timeslot ts, packet_pool &pool)
+{
+  pool.give_spare(spare[ts % 2][w], w);
+}
+
+void
+pool_balancer::take(int w, timeslot ts, packet_pool &pool)
+{
+  // The packets of the time slot before ts are in the buffers of the
+  // parity of ts + 1.
+  for(int s = 0; s < spare[0].size(); ++s)
+    pool.take_spare(spare[(ts + 1) % 2][s][w]);
+}
@@ -0,0 +1,113 @@
+#ifndef PACKET_POOL_HPP
+#define PACKET_POOL_HPP
+
+#include "config.hpp"
+#include "graph.hpp"
+#include "packet.hpp"
+
+#include <vector>
+
+/**
+ * The pool of packets.  The simulation creates and destroys packets
+ * all the time, and so instead of using the new and delete operators,
+ * the packets are taken from and returned to the pool.  The pool
+ * allocates memory in chunks of many packets, and keeps the released
+ * packets on a free list.
+ *
+ * A pool is used by a single thread only, but a packet can be
+ * released to a pool different from the one it was taken from,
+ * because packets travel between the nodes of different threads.
+ * That's fine as long as no pool is destroyed before all the pools
+ * are done with the packets.  When one thread mostly sends and
+ * another mostly receives, the free packets pile up in the pool of
+ * the receiving thread, and so the threads hand their spare packets
+ * over with the pool_balancer.
+ */
+class packet_pool
+{
+  /// The number of packets in a chunk.
+  static const int chunk_size = 1024;
+
+  /// The chunks of memory allocated by this pool.
+  std::vector<void *> chunks;
+
+  /// The free list of packets.
+  std::vector<packet *> free_pkts;
+
+  // We don't want to copy the pool.
+  packet_pool(const packet_pool &);
+  packet_pool &operator = (const packet_pool &);
+
+public:
+  packet_pool();
+
+  /**
+   * Frees the chunks of this pool.  The packets taken from this pool
+   * become invalid.
+   */
+  ~packet_pool();
+
+  /**
+   * Returns a new packet, which is constructed with the given
+   * arguments.
+   */
+  packet *alloc(Vertex src, Vertex dst, timeslot start_ts);
+
+  /**
+   * Returns the packet to the pool.
+   */
+  void release(packet *pkt);
+
+  /**
+   * Takes the free packets above a chunk out of the pool, and spreads
+   * them evenly over the buffers, except buffer self.
+   */
+  void give_spare(std::vector<slot_pkts> &bufs, int self);
+
+  /**
+   * Puts the free packets of the buffer into the pool, and clears the
+   * buffer.
+   */
+  void take_spare(slot_pkts &buf);
+
+  /**
+   * Returns the number of chunks allocated by this pool.
+   */
+  int chunk_count() const;
+};
+
+/**
+ * Moves the free packets between the pools of the simulation
+ * threads.  At the end of a time slot a thread hands over the spare
+ * packets of its pool to the other threads, and they take them at
+ * the beginning of the next time slot, after the barrier.  As with
+ * the exchange buffers of packets, we need two time slots, because a
+ * thread can already hand over packets in the next time slot, while
+ * other threads are still taking the packets of the previous one.
+ */
+class pool_balancer
+{
+  /// Element [p][s][d] keeps the free packets that thread s handed
+  /// over to thread d in a time slot of parity p.
+  std::vector<std::vector<std::vector<slot_pkts> > > spare;
+
+public:
+  /**
+   * Creates the balancer for the given number of threads.
+   */
+  pool_balancer(int nt);
+
+  /**
+   * Hands over the spare packets of the pool of thread w at the end
+   * of time slot ts.
+   */
+  void give(int w, timeslot ts, packet_pool &pool);
+
+  /**
+   * Takes into the pool of thread w the packets handed over to it in
+   * the time slot before ts.
+   */
+  void take(int w, timeslot ts, packet_pool &pool);
+};
+
+#endif /* PACKET_POOL_HPP */
@@ -0,0 +1,108 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+
+#include <boost/progress.hpp>
+#include <boost/ref.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+/**
+ * The worker of function parallel_for.  The workers take the next
+ * index to process, until there are no indexes left.
+ */
+template<typename F>
+class parallel_for_worker
+{
+  F &f;
+  int n;
+  int &next;
+  boost::mutex &m;
+
+public:
+  parallel_for_worker(F &f, int n, int &next, boost::mutex &m) :
+    f(f), n(n), next(next), m(m)
+  {
+  }
+
+  void operator()()
+  {
+    while(true)
+      {
+        int i;
+
+        {
+          boost::mutex::scoped_lock lock(m);
+          if (next == n)
+            return;
+          i = next++;
+        }
+
+        f(i);
+      }
+  }
+};
+
+/**
+ * Calls f(i) for i from 0 to (n - 1) using the given number of
+ * threads.  The calls are made in no specific order, and so f has to
+ * be safe to call concurrently for different i.  With a single
+ * thread the calls are made in order by the calling thread.
+ *
+ * @param n the number of indexes
+ *
+ * @param threads the number of threads
+ *
+ * @param f the function object
+ */
+template<typename F>
+void
+parallel_for(int n, int threads, F &f)
+{
+  threads = std::min(threads, n);
+
+  if (threads <= 1)
+    for(int i = 0; i < n; ++i)
+      f(i);
+  else
+    {
+      int next = 0;
+      boost::mutex m;
+      parallel_for_worker<F> w(f, n, next, m);
+
+      boost::thread_group tg;
+      for(int t = 0; t < threads; ++t)
+        tg.create_thread(boost::ref(w));
+      tg.join_all();
+    }
+}
+
+/**
+ * The progress display shared by threads.
+ */
+class parallel_progress
+{
+  boost::progress_display pd;
+  boost::mutex m;
+
+public:
+  parallel_progress(unsigned long expected_count, std::ostream &os) :
+    pd(expected_count, os)
+  {
+  }
+
+  void operator++()
+  {
+    boost::mutex::scoped_lock lock(m);
+    ++pd;
+  }
+
+  void operator+=(unsigned long increment)
+  {
+    boost::mutex::scoped_lock lock(m);
+    pd += increment;
+  }
+};
+
+#endif /* PARALLEL_HPP */
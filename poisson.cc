@@ -16,21 +16,12 @@ BOOST_CLASS_EXPORT(poisson)
 
 using namespace std;
 
-poisson::poisson() : lambda(1)
+poisson::poisson() : lambda(1), k_left(0), k_right(0)
 {
 }
 
-poisson::poisson(double l) : lambda(l)
+poisson::poisson(double l) : lambda(l), k_left(0), k_right(0)
 {
-  int k = mode(lambda);
-  double f = gsl_ran_poisson_pdf(k, lambda);
-
-  // This is the maximum.  We can't get a bigger value than this one.
-  // We can at most get an equal value.
-  distro.push_back(make_pair(f, k));
-
-  k_left = k - 1;
-  k_right = k + 1;
 }
 
 poisson *
@@ -48,6 +39,9 @@ poisson::exists_ith_max(int i) const
 prob_pair
 poisson::get_ith_max(int i) const
 {
+  if (distro.empty())
+    figure_out_mode();
+
   while(distro.size() <= i)
     figure_out_next();
 
@@ -142,6 +136,22 @@ poisson::mode(double lambda)
   return mode;
 }
 
+void
+poisson::figure_out_mode() const
+{
+  assert(distro.empty());
+
+  int k = mode(lambda);
+  double f = gsl_ran_poisson_pdf(k, lambda);
+
+  // This is the maximum.  We can't get a bigger value than this one.
+  // We can at most get an equal value.
+  distro.push_back(make_pair(f, k));
+
+  k_left = k - 1;
+  k_right = k + 1;
+}
+
 void
 poisson::figure_out_next() const
 {
@@ -4,8 +4,8 @@
 #include "counter.hpp"
 #include "distro_base.hpp"
 
-#include <deque>
 #include <utility>
+#include <vector>
 
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/base_object.hpp>
@@ -25,14 +25,18 @@ class poisson : public distro_base, private counter<poisson>
   double lambda;
 
   /**
-   * This is the cache of the known probabilities.
+   * This is the cache of the known probabilities.  It's filled only
+   * when the probabilities are asked for, and so creating and
+   * copying a poisson that is only added or scaled doesn't allocate
+   * memory.
    */
-  mutable deque<prob_pair> distro;
+  mutable vector<prob_pair> distro;
 
   /**
    * These are the smallest and largest values of k that will be
    * examined next.  The integer values between (k_left + 1) and
    * (k_right - 1) including them are already in the distro object.
+   * They are valid once the distro object is not empty.
    */
   mutable int k_left, k_right;
 
@@ -73,6 +77,11 @@ public:
 
 private:
   void figure_out_next() const;
+
+  /**
+   * Puts the mode into the empty cache.
+   */
+  void figure_out_mode() const;
 };
 
 #endif /* POISSON_HPP */
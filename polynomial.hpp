@@ -4,13 +4,19 @@
 #include "counter.hpp"
 #include "distro.hpp"
 
+#ifdef DENSE_POLY
+#include "term_vector.hpp"
+#endif
+
 #include <algorithm>
 #include <cstddef>
 #include <limits>
 #include <map>
 #include <ostream>
+#include <vector>
 
 #include <boost/serialization/map.hpp>
+#include <boost/serialization/split_member.hpp>
 
 using namespace std;
 
@@ -25,13 +31,27 @@ using namespace std;
  * terms that have the power equal or higher then S.  We achieve this
  * easily in the multiplication operators defined for this type: we
  * just discard the terms with too high a power.
+ *
+ * The terms are kept in a map, unless DENSE_POLY is defined at
+ * compile time, in which case they are kept contiguously in a
+ * term_vector.  Either way the polynomial has the same interface and
+ * is serialized the same way.
  */
+#ifdef DENSE_POLY
+template<typename T>
+class tpoly : public term_vector<T>, private counter<tpoly<T> >
+#else
 template<typename T>
 class tpoly : public map<size_t, T>, private counter<tpoly<T> >
+#endif
 {
   friend class boost::serialization::access;
 
+#ifdef DENSE_POLY
+  typedef term_vector<T> base_type;
+#else
   typedef map<size_t, T> base_type;
+#endif
 
   /**
    * This is the number which limits the number of terms in the
@@ -47,6 +67,93 @@ class tpoly : public map<size_t, T>, private counter<tpoly<T> >
    */
   static T itsTrash;
 
+#ifdef DENSE_POLY
+  /**
+   * A term saved as an element of map<size_t, T>.  It refers to the
+   * power and the coefficient of the term, and doesn't copy them.
+   */
+  struct map_term
+  {
+    const size_t &first;
+    const T &second;
+
+    map_term(const size_t &first, const T &second) :
+      first(first), second(second)
+    {
+    }
+
+    template<class Archive>
+    void serialize(Archive &ar, const unsigned int version)
+    {
+      ar & boost::serialization::make_nvp
+        ("first", const_cast<size_t &>(first));
+      ar & boost::serialization::make_nvp
+        ("second", const_cast<T &>(second));
+    }
+  };
+
+  /**
+   * The terms saved the way map<size_t, T> is saved: the number of
+   * terms and the version of the elements, and then the terms.
+   */
+  struct map_view
+  {
+    const tpoly &p;
+
+    map_view(const tpoly &p) : p(p)
+    {
+    }
+
+    template<class Archive>
+    void serialize(Archive &ar, const unsigned int version)
+    {
+      boost::serialization::collection_size_type count(p.size());
+      ar << BOOST_SERIALIZATION_NVP(count);
+
+      const boost::serialization::item_version_type item_version
+        (boost::serialization::version<pair<const size_t, T> >::value);
+      ar << BOOST_SERIALIZATION_NVP(item_version);
+
+      for(typename base_type::const_iterator
+            i = p.base_type::begin(); i != p.base_type::end(); ++i)
+        {
+          const map_term t(i->first, i->second);
+          ar << boost::serialization::make_nvp("item", t);
+        }
+    }
+  };
+
+  /**
+   * We save the terms as a map, so that the archives don't depend on
+   * how the terms are kept.  The terms are saved in place, and not
+   * from a copy, because the distributions are saved through
+   * pointers, which the archive tracks by their addresses.
+   */
+  template<class Archive>
+  void save(Archive &ar, const unsigned int version) const
+  {
+    const map_view mv(*this);
+    ar & mv;
+  }
+
+  /**
+   * We load the terms from a map.
+   */
+  template<class Archive>
+  void load(Archive &ar, const unsigned int version)
+  {
+    map<size_t, T> m;
+    ar & m;
+
+    this->clear();
+    this->reserve(m.size());
+    for(typename map<size_t, T>::const_iterator
+          i = m.begin(); i != m.end(); ++i)
+      this->push_back(i->first, i->second);
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+#else
   /**
    * Serialization function.
    */
@@ -55,6 +162,7 @@ class tpoly : public map<size_t, T>, private counter<tpoly<T> >
   {
     ar & boost::serialization::base_object<base_type>(*this);
   }
+#endif
 
 public:
   tpoly() {}
@@ -118,6 +226,7 @@ public:
 /**
  * The operator: tpoly<A> * tpoly<B>.
  */
+#ifndef DENSE_POLY
 template<typename A, typename B>
 tpoly<B>
 operator * (const tpoly<A> &p1, const tpoly<B> &p2)
@@ -137,6 +246,107 @@ operator * (const tpoly<A> &p1, const tpoly<B> &p2)
 
   return result;
 }
+#else
+template<typename A, typename B>
+tpoly<B>
+operator * (const tpoly<A> &p1, const tpoly<B> &p2)
+{
+  tpoly<B> result;
+
+  if (p1.empty() || p2.empty())
+    return result;
+
+  // The powers of the terms of p2 are from o2 to (o2 + n2 - 1), and
+  // index2[k] tells where in p2 the term of power (o2 + k) is, or -1
+  // if there is no such term.
+  size_t o2 = p2.begin()->first;
+  size_t n2 = p2.rbegin()->first - o2 + 1;
+  vector<int> index2(n2, -1);
+  for(typename tpoly<B>::const_iterator j = p2.begin(); j != p2.end(); ++j)
+    index2[j->first - o2] = j - p2.begin();
+
+  // The powers of the result that we care about: from lo to (hi - 1).
+  size_t lo = p1.begin()->first + o2;
+  size_t hi = min(p1.rbegin()->first + o2 + n2, (size_t)tpoly<B>::get_S());
+
+  // We produce the terms of the result in the order of their powers,
+  // and so they are only appended to the result.
+  for(size_t k = lo; k < hi; ++k)
+    for(typename tpoly<A>::const_iterator
+          i = p1.begin(); i != p1.end() && i->first + o2 <= k; ++i)
+      {
+        size_t d = k - i->first - o2;
+
+        if (d < n2 && index2[d] >= 0)
+          result[k] += i->second * (p2.begin() + index2[d])->second;
+      }
+
+  return result;
+}
+
+/**
+ * The operator: fp_poly * fp_poly.  The coefficients are put into
+ * dense arrays with the gaps filled with zeros, so that the truncated
+ * convolution is made of plain loops that the compiler vectorises.
+ * Along with the coefficients we convolve the flags of the existing
+ * terms to know which terms of the result exist.
+ */
+inline tpoly<double>
+operator * (const tpoly<double> &p1, const tpoly<double> &p2)
+{
+  tpoly<double> result;
+
+  if (p1.empty() || p2.empty())
+    return result;
+
+  size_t o1 = p1.begin()->first;
+  size_t n1 = p1.rbegin()->first - o1 + 1;
+  size_t o2 = p2.begin()->first;
+  size_t n2 = p2.rbegin()->first - o2 + 1;
+
+  size_t S = tpoly<double>::get_S();
+  if (o1 + o2 >= S)
+    return result;
+
+  // The number of the terms of the result that we care about.
+  size_t n = min(n1 + n2 - 1, S - o1 - o2);
+
+  vector<double> a(n1), b(n2), c(n);
+  vector<unsigned char> ea(n1), eb(n2), ec(n);
+
+  for(tpoly<double>::const_iterator i = p1.begin(); i != p1.end(); ++i)
+    {
+      a[i->first - o1] = i->second;
+      ea[i->first - o1] = 1;
+    }
+
+  for(tpoly<double>::const_iterator j = p2.begin(); j != p2.end(); ++j)
+    {
+      b[j->first - o2] = j->second;
+      eb[j->first - o2] = 1;
+    }
+
+  for(size_t i = 0; i < n1 && i < n; ++i)
+    {
+      size_t m = min(n2, n - i);
+      double ai = a[i];
+      unsigned char eai = ea[i];
+
+      for(size_t j = 0; j < m; ++j)
+        {
+          c[i + j] += ai * b[j];
+          ec[i + j] |= eai & eb[j];
+        }
+    }
+
+  result.reserve(n);
+  for(size_t k = 0; k < n; ++k)
+    if (ec[k])
+      result.push_back(o1 + o2 + k, c[k]);
+
+  return result;
+}
+#endif
 
 /**
  * The *= operator for tpoly<T>.
@@ -155,6 +365,7 @@ operator *= (tpoly<A> &p1, const B &c)
  * The addition operator for polynomials with coefficients of the same
  * type.
  */
+#ifndef DENSE_POLY
 template<typename T>
 tpoly<T> &
 operator += (tpoly<T> &p1, const tpoly<T> &p2)
@@ -164,6 +375,50 @@ operator += (tpoly<T> &p1, const tpoly<T> &p2)
     p1[i->first] += i->second;
   return p1;
 }
+#else
+template<typename T>
+tpoly<T> &
+operator += (tpoly<T> &p1, const tpoly<T> &p2)
+{
+  if (p2.empty())
+    return p1;
+
+  if (p1.empty())
+    {
+      p1 = p2;
+      return p1;
+    }
+
+  // We merge the terms of both polynomials, which are sorted.
+  tpoly<T> result;
+  result.reserve(p1.size() + p2.size());
+
+  typename tpoly<T>::const_iterator i = p1.begin();
+  typename tpoly<T>::const_iterator j = p2.begin();
+
+  while(i != p1.end() || j != p2.end())
+    if (j == p2.end() || (i != p1.end() && i->first < j->first))
+      {
+        result.push_back(i->first, i->second);
+        ++i;
+      }
+    else if (i == p1.end() || j->first < i->first)
+      {
+        result.push_back(j->first, j->second);
+        ++j;
+      }
+    else
+      {
+        result.push_back(i->first, i->second);
+        result.rbegin()->second += j->second;
+        ++i, ++j;
+      }
+
+  p1.swap(result);
+
+  return p1;
+}
+#endif
 
 /**
  * The addition operator for polynomials with coefficients of the same
@@ -1,18 +1,194 @@
 #include "rand.hpp"
 
 #include <cassert>
-#include <cstdlib>
+#include <cmath>
 
-void mysrand(unsigned int n)
+/**
+ * The multipliers and the key increments of Philox4x32.
+ */
+static const boost::uint32_t philox_m0 = 0xD2511F53;
+static const boost::uint32_t philox_m1 = 0xCD9E8D57;
+static const boost::uint32_t philox_w0 = 0x9E3779B9;
+static const boost::uint32_t philox_w1 = 0xBB67AE85;
+
+/**
+ * The number of rounds of Philox4x32.
+ */
+static const int philox_rounds = 10;
+
+/**
+ * The means from which the Poisson distribution is sampled with the
+ * transformed rejection.
+ */
+static const double ptrs_mu = 10;
+
+stream_rng::stream_rng(unsigned long seed, boost::uint32_t j, timeslot ts,
+                       purpose_t purpose) : used(4)
+{
+  boost::uint64_t s = seed;
+  boost::uint64_t t = ts;
+
+  key[0] = j;
+  key[1] = boost::uint32_t(s) ^ boost::uint32_t(s >> 32);
+
+  ctr[0] = 0;
+  ctr[1] = boost::uint32_t(t);
+  ctr[2] = boost::uint32_t(t >> 32);
+  ctr[3] = purpose;
+}
+
+void
+stream_rng::next_block()
+{
+  boost::uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+  boost::uint32_t k0 = key[0], k1 = key[1];
+
+  for(int r = 0; r < philox_rounds; ++r)
+    {
+      boost::uint64_t p0 = boost::uint64_t(philox_m0) * c0;
+      boost::uint64_t p1 = boost::uint64_t(philox_m1) * c2;
+
+      c0 = boost::uint32_t(p1 >> 32) ^ c1 ^ k0;
+      c1 = boost::uint32_t(p1);
+      c2 = boost::uint32_t(p0 >> 32) ^ c3 ^ k1;
+      c3 = boost::uint32_t(p0);
+
+      k0 += philox_w0;
+      k1 += philox_w1;
+    }
+
+  block[0] = c0;
+  block[1] = c1;
+  block[2] = c2;
+  block[3] = c3;
+  used = 0;
+
+  // A stream has 2^32 blocks, far more than a node draws in a time
+  // slot.
+  ++ctr[0];
+}
+
+void
+stream_rng::uniform(double *u, size_t n)
+{
+  // Use up the current block first.
+  while(n && used < 4)
+    {
+      *u++ = uniform();
+      --n;
+    }
+
+  // Then take whole blocks.
+  for(; n >= 4; n -= 4, u += 4)
+    {
+      next_block();
+      for(int i = 0; i < 4; ++i)
+        u[i] = block[i] * (1.0 / 4294967296.0);
+      used = 4;
+    }
+
+  while(n--)
+    *u++ = uniform();
+}
+
+boost::uint32_t
+stream_rng::uniform_int(boost::uint64_t n)
+{
+  assert(n >= 1 && n <= (boost::uint64_t(1) << 32));
+
+  // The multiply-and-shift method of Lemire, with the rejection of
+  // the few words that would make the result biased.
+  boost::uint64_t m = get() * n;
+
+  if (boost::uint32_t(m) < n)
+    {
+      boost::uint64_t t = (boost::uint64_t(1) << 32) % n;
+      while(boost::uint32_t(m) < t)
+        m = get() * n;
+    }
+
+  return boost::uint32_t(m >> 32);
+}
+
+int
+stream_rng::poisson(double mu)
 {
-  srand(n);
+  assert(mu >= 0);
+
+  if (mu < ptrs_mu)
+    {
+      // The inversion by sequential search.
+      double p = exp(-mu);
+      double F = p;
+      double u = uniform();
+      int k = 0;
+
+      while(u > F && p > 0)
+        {
+          ++k;
+          p *= mu / k;
+          F += p;
+        }
+
+      return k;
+    }
+
+  // The transformed rejection with squeeze, PTRS.
+  double slam = sqrt(mu);
+  double loglam = log(mu);
+  double b = 0.931 + 2.53 * slam;
+  double a = -0.059 + 0.02483 * b;
+  double invalpha = 1.1239 + 1.1328 / (b - 3.4);
+  double vr = 0.9277 - 3.6224 / (b - 2);
+
+  while(true)
+    {
+      double U = uniform() - 0.5;
+      double V = uniform();
+      double us = 0.5 - fabs(U);
+      double k = floor((2 * a / us + b) * U + mu + 0.43);
+
+      if (us >= 0.07 && V <= vr)
+        return int(k);
+
+      if (k < 0 || (us < 0.013 && V > us))
+        continue;
+
+      if (log(V) + log(invalpha) - log(a / (us * us) + b) <=
+          -mu + k * loglam - lgamma(k + 1))
+        return int(k);
+    }
 }
 
-int myrand(int n)
+int
+stream_rng::poisson_positive(double mu)
 {
-  int ret = (int) (((float) n * (float) rand()) /
-                   ((float) RAND_MAX + 1.0));
-  
-  assert(ret < n);
-  return ret;
+  assert(mu > 0);
+
+  if (mu < ptrs_mu)
+    {
+      // The inversion by sequential search, with the uniform number
+      // mapped above the probability of 0.
+      double p = exp(-mu);
+      double F = p;
+      double u = p - expm1(-mu) * uniform();
+      int k = 0;
+
+      while(!k || (u > F && p > 0))
+        {
+          ++k;
+          p *= mu / k;
+          F += p;
+        }
+
+      return k;
+    }
+
+  // The probability of 0 is below exp(-ptrs_mu), and so we simply
+  // draw again.
+  int k;
+  while(!(k = poisson(mu)))
+    ;
+
+  return k;
 }
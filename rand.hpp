@@ -1,14 +1,101 @@
 #ifndef RAND_HPP
 #define RAND_HPP
 
-/**
- * Sets the seed of the random generator.
- */
-void mysrand(unsigned int n);
+#include "config.hpp"
+
+#include <cstddef>
+
+#include <boost/cstdint.hpp>
 
 /**
- * Returns a random number between 0 and (n - 1).
+ * The counter-based random number generator of the simulation.  It's
+ * the Philox4x32-10 generator of Salmon et al.: the random numbers
+ * are the encrypted values of a counter, and so a stream is given by
+ * its key and its counter, and there is no state to carry from one
+ * time slot to the next.
+ *
+ * A stream is keyed with the seed and the node, and its counter
+ * starts at the time slot and the purpose of the numbers.  The
+ * numbers drawn by a node in a time slot for a given purpose are then
+ * the same no matter how many threads simulate the network, in what
+ * order the nodes are simulated, or how many numbers were drawn for
+ * other purposes.
+ *
+ * We define the frequently used functions inline.
  */
-int myrand(int n);
+class stream_rng
+{
+  /// The key: the node and the folded seed.
+  boost::uint32_t key[2];
+
+  /// The counter: the block number, the time slot and the purpose.
+  boost::uint32_t ctr[4];
+
+  /// The block of the random words of the current counter.
+  boost::uint32_t block[4];
+
+  /// The number of words of the block already used.
+  int used;
+
+  /**
+   * Encrypts the counter into the block, and increments the counter.
+   */
+  void next_block();
+
+public:
+  /// The purposes of the random numbers.
+  enum purpose_t {GENERATION, ADMISSION, GAP};
+
+  /**
+   * Creates the stream of node j for the time slot ts and the
+   * purpose.
+   */
+  stream_rng(unsigned long seed, boost::uint32_t j, timeslot ts,
+             purpose_t purpose);
+
+  /**
+   * Returns a random 32-bit word.
+   */
+  boost::uint32_t get()
+  {
+    if (used == 4)
+      next_block();
+
+    return block[used++];
+  }
+
+  /**
+   * Returns a random number uniformly distributed in [0, 1).
+   */
+  double uniform()
+  {
+    return get() * (1.0 / 4294967296.0);
+  }
+
+  /**
+   * Fills u with n random numbers uniformly distributed in [0, 1).
+   * The numbers are taken a block at a time.
+   */
+  void uniform(double *u, size_t n);
+
+  /**
+   * Returns a random integer uniformly distributed from 0 to (n - 1),
+   * without the modulo bias.  The n has to be from 1 to 2^32.
+   */
+  boost::uint32_t uniform_int(boost::uint64_t n);
+
+  /**
+   * Returns a random number with the Poisson distribution of mean
+   * mu.  The small means are sampled by inversion, and the large
+   * with the transformed rejection of Hoermann.
+   */
+  int poisson(double mu);
+
+  /**
+   * Returns a random number with the Poisson distribution of mean mu
+   * conditioned on being positive.  The mu has to be positive.
+   */
+  int poisson_positive(double mu);
+};
 
 #endif /* RAND_HPP */
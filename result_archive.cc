@@ -0,0 +1,396 @@
+#include "result_archive.hpp"
+
+#include "distro.hpp"
+#include "geometric.hpp"
+#include "graph_serialization.hpp"
+#include "nodistro.hpp"
+#include "poisson.hpp"
+#include "tabdistro.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/serialization/string.hpp>
+
+using namespace std;
+
+/**
+ * The magic at the beginning of the archive.
+ */
+static const char magic[8] = "OPUSRES";
+
+/**
+ * Puts the section with the given number of records of the given
+ * size at the first offset aligned to eight bytes, starting from the
+ * offset given.  The offset is moved past the section.
+ */
+static ra::section
+place(boost::uint64_t &offset, size_t size, size_t record)
+{
+  ra::section s;
+  s.offset = (offset + 7) & ~boost::uint64_t(7);
+  s.size = size;
+  offset = s.offset + size * record;
+
+  return s;
+}
+
+/**
+ * Writes the records of the section, padding the file up to the
+ * offset of the section.  The position pos is moved past the section.
+ */
+template<typename T>
+static void
+write_section(ostream &out, boost::uint64_t &pos, const ra::section &s,
+              const vector<T> &v)
+{
+  static const char zeros[8] = {};
+
+  assert(s.offset >= pos && s.offset - pos < 8);
+  assert(s.size == v.size());
+
+  out.write(zeros, s.offset - pos);
+  if (!v.empty())
+    out.write(reinterpret_cast<const char *>(&v[0]), v.size() * sizeof(T));
+  pos = s.offset + v.size() * sizeof(T);
+}
+
+/**
+ * Flattens the distribution into the term and the coefficients.
+ */
+static void
+flatten(const distro &d, ra::term &t, vector<double> &coefs)
+{
+  t.coef = coefs.size();
+
+  if (d.is_poisson())
+    {
+      t.kind = ra::POISSON;
+      coefs.push_back(d.mean());
+    }
+  else if (d.is_geometric())
+    {
+      // The probability of success is the probability of 1.
+      t.kind = ra::GEOMETRIC;
+      coefs.push_back(d.get_prob(1));
+    }
+  else if (d.is_tabdistro())
+    {
+      t.kind = ra::TABDISTRO;
+
+      int max_v = 0;
+      for(int k = 0; d.exists_ith_max(k); ++k)
+        max_v = max(max_v, d.get_ith_max(k).second);
+
+      for(int v = 0; v <= max_v; ++v)
+        coefs.push_back(d.get_prob(v));
+    }
+  else
+    t.kind = ra::NODISTRO;
+
+  t.n_coefs = coefs.size() - t.coef;
+}
+
+/**
+ * Returns the distribution of the term.
+ */
+static distro
+unflatten(const ra::term &t, const double *coefs)
+{
+  const double *c = coefs + t.coef;
+
+  switch(t.kind)
+    {
+    case ra::POISSON:
+      return poisson(c[0]);
+    case ra::GEOMETRIC:
+      return geometric(c[0]);
+    case ra::TABDISTRO:
+      return tabdistro(vector<double>(c, c + t.n_coefs));
+    default:
+      return nodistro();
+    }
+}
+
+bool
+save_result_archive(const string &name, const arguments &args,
+                    const Graph &g, const fp_matrix &tm,
+                    const pt_matrix &ptm)
+{
+  // The arguments, the graph and the traffic matrix.
+  string meta;
+  {
+    ostringstream str;
+    {
+      boost::archive::text_oarchive oa(str);
+      oa << args;
+      oa << g;
+      oa << tm;
+    }
+    meta = str.str();
+  }
+
+  vector<char> metas(meta.begin(), meta.end());
+
+  // The links, and their indexes.  The graph is undirected, but the
+  // loads and the trajectories are for the links, i.e. the edges in
+  // either direction, and so every edge has two records.
+  vector<ra::edge> edge_recs;
+  map<Edge, boost::uint64_t> index;
+  BGL_FORALL_EDGES(e, g, Graph)
+    {
+      Vertex s = source(e, g);
+      Vertex t = target(e, g);
+      Edge links[] = {edge(s, t, g).first, edge(t, s, g).first};
+
+      for(int d = 0; d < 2; ++d)
+        {
+          ra::edge r = {0, 0, false, 0, 0};
+          r.source = source(links[d], g);
+          r.target = target(links[d], g);
+          index[links[d]] = edge_recs.size();
+          edge_recs.push_back(r);
+        }
+    }
+
+  {
+    map<Edge, double> ll;
+    calculate_ll(ptm, ll, g);
+    for(map<Edge, double>::const_iterator
+          i = ll.begin(); i != ll.end(); ++i)
+      {
+        map<Edge, boost::uint64_t>::const_iterator k = index.find(i->first);
+        assert(k != index.end());
+        ra::edge &r = edge_recs[k->second];
+        r.used = true;
+        r.load = i->second;
+      }
+  }
+
+  // The flattened packet trajectory matrix.
+  vector<ra::demand> demands;
+  vector<ra::hop> hops;
+  vector<ra::link> links;
+  vector<ra::term> terms;
+  vector<double> coefs;
+
+  FOREACH_MATRIX_ELEMENT(ptm, i, j, e, pt_matrix)
+    {
+      ra::demand d = {0, 0, 0, 0, hops.size(), e.size()};
+      d.dst = i;
+      d.src = j;
+
+      if (tm.exists(i, j))
+        d.in_rate = tm.at(i, j);
+
+      for(packet_trajectory::const_iterator
+            t = e.begin(); t != e.end(); ++t)
+        {
+          ra::hop hr = {t->first, links.size(), t->second.size()};
+          hops.push_back(hr);
+
+          for(packet_trajectory::mapped_type::const_iterator
+                l = t->second.begin(); l != t->second.end(); ++l)
+            {
+              map<Edge, boost::uint64_t>::const_iterator
+                k = index.find(l->first);
+              assert(k != index.end());
+
+              ra::link r = {k->second, terms.size(), l->second.size()};
+              links.push_back(r);
+
+              for(dist_poly::const_iterator
+                    p = l->second.begin(); p != l->second.end(); ++p)
+                {
+                  ra::term term = {p->first, 0, 0, 0, 0};
+                  flatten(p->second, term, coefs);
+                  terms.push_back(term);
+                }
+            }
+        }
+
+      d.out_rate = calculate_delivered(e, i, g);
+      demands.push_back(d);
+    }
+
+  // The header.
+  ra::header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, magic, sizeof(magic));
+  h.version = RESULT_ARCHIVE_VERSION;
+
+  boost::uint64_t offset = sizeof(h);
+  h.meta = place(offset, metas.size(), sizeof(char));
+  h.edges = place(offset, edge_recs.size(), sizeof(ra::edge));
+  h.demands = place(offset, demands.size(), sizeof(ra::demand));
+  h.hops = place(offset, hops.size(), sizeof(ra::hop));
+  h.links = place(offset, links.size(), sizeof(ra::link));
+  h.terms = place(offset, terms.size(), sizeof(ra::term));
+  h.coefs = place(offset, coefs.size(), sizeof(double));
+
+  ofstream out(name.c_str(), ios::binary);
+
+  if (!out)
+    return false;
+
+  out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+
+  boost::uint64_t pos = sizeof(h);
+  write_section(out, pos, h.meta, metas);
+  write_section(out, pos, h.edges, edge_recs);
+  write_section(out, pos, h.demands, demands);
+  write_section(out, pos, h.hops, hops);
+  write_section(out, pos, h.links, links);
+  write_section(out, pos, h.terms, terms);
+  write_section(out, pos, h.coefs, coefs);
+
+  return out.good();
+}
+
+result_archive::result_archive() : h(0)
+{
+}
+
+bool
+result_archive::open(const string &name)
+{
+  using namespace boost::interprocess;
+
+  h = 0;
+
+  try
+    {
+      file_mapping f(name.c_str(), read_only);
+      mapped_region r(f, read_only);
+      file.swap(f);
+      region.swap(r);
+    }
+  catch(const interprocess_exception &)
+    {
+      return false;
+    }
+
+  size_t size = region.get_size();
+
+  if (size < sizeof(ra::header))
+    return false;
+
+  const ra::header *p =
+    static_cast<const ra::header *>(region.get_address());
+
+  if (memcmp(p->magic, magic, sizeof(magic)) ||
+      p->version != RESULT_ARCHIVE_VERSION)
+    return false;
+
+  // Make sure the sections are in the file.
+  const ra::section *s[] = {&p->meta, &p->edges, &p->demands, &p->hops,
+                            &p->links, &p->terms, &p->coefs};
+  const size_t record[] = {sizeof(char), sizeof(ra::edge),
+                           sizeof(ra::demand), sizeof(ra::hop),
+                           sizeof(ra::link), sizeof(ra::term),
+                           sizeof(double)};
+
+  for(int i = 0; i < sizeof(s) / sizeof(s[0]); ++i)
+    if (s[i]->offset > size ||
+        s[i]->size > (size - s[i]->offset) / record[i])
+      return false;
+
+  h = p;
+
+  return true;
+}
+
+void
+result_archive::load_meta(arguments &args, Graph &g, fp_matrix &tm) const
+{
+  assert(h);
+
+  istringstream str(string(records<char>(h->meta), h->meta.size));
+  boost::archive::text_iarchive ia(str);
+  ia >> args;
+  ia >> g;
+  ia >> tm;
+}
+
+void
+result_archive::load_ll(const Graph &g, map<Edge, double> &ll) const
+{
+  assert(h);
+  assert(ll.empty());
+
+  const ra::edge *er = records<ra::edge>(h->edges);
+
+  for(size_t k = 0; k < h->edges.size; ++k)
+    if (er[k].used)
+      ll[edge(er[k].source, er[k].target, g).first] = er[k].load;
+}
+
+size_t
+result_archive::demands() const
+{
+  assert(h);
+
+  return h->demands.size;
+}
+
+const ra::demand &
+result_archive::demand(size_t k) const
+{
+  assert(h);
+  assert(k < h->demands.size);
+
+  return records<ra::demand>(h->demands)[k];
+}
+
+void
+result_archive::load_trajectory(const Graph &g, size_t k,
+                                packet_trajectory &pt) const
+{
+  assert(h);
+  assert(k < h->demands.size);
+  assert(pt.empty());
+
+  const ra::edge *edge_recs = records<ra::edge>(h->edges);
+  const ra::hop *hops = records<ra::hop>(h->hops);
+  const ra::link *links = records<ra::link>(h->links);
+  const ra::term *terms = records<ra::term>(h->terms);
+  const double *coefs = records<double>(h->coefs);
+  const ra::demand &dr = demand(k);
+
+  for(size_t t = dr.hop; t < dr.hop + dr.n_hops; ++t)
+    {
+      map<Edge, dist_poly> &hop = pt[hops[t].number];
+
+      for(size_t l = hops[t].link; l < hops[t].link + hops[t].n_links; ++l)
+        {
+          const ra::edge &er = edge_recs[links[l].edge];
+          Edge e = edge(er.source, er.target, g).first;
+          dist_poly &p = hop[e];
+
+          for(size_t k = links[l].term;
+              k < links[l].term + links[l].n_terms; ++k)
+            p[terms[k].power] = unflatten(terms[k], coefs);
+        }
+    }
+}
+
+void
+result_archive::load_ptm(const Graph &g, pt_matrix &ptm) const
+{
+  assert(h);
+  assert(ptm.empty());
+
+  for(size_t k = 0; k < h->demands.size; ++k)
+    {
+      const ra::demand &dr = demand(k);
+      load_trajectory(g, k, ptm[dr.dst][dr.src]);
+    }
+}
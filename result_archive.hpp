@@ -0,0 +1,200 @@
+#ifndef RESULT_ARCHIVE_HPP
+#define RESULT_ARCHIVE_HPP
+
+#include "arguments.hpp"
+#include "graph.hpp"
+#include "matrixes.hpp"
+
+#include <map>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+using namespace std;
+
+/**
+ * The version of the binary result archive.  Increase it when the
+ * layout changes.
+ */
+#define RESULT_ARCHIVE_VERSION 2
+
+/**
+ * The binary result archive.  The archive is a header followed by
+ * sections, which are arrays of the records below, every aligned to
+ * eight bytes.  The arguments, the graph and the traffic matrix are
+ * small, and so they are kept in the meta section as a text archive.
+ * The packet trajectory matrix is flattened: a demand refers to its
+ * hops, a hop to its links, a link to the terms of its polynomial,
+ * and a term to the coefficients of its distribution.
+ *
+ * The link loads and the rates of the demands are calculated when
+ * the archive is saved, and so they are read without loading the
+ * trajectories.
+ */
+namespace ra
+{
+  /// The section of the archive: its offset and the number of records.
+  struct section
+  {
+    boost::uint64_t offset;
+    boost::uint64_t size;
+  };
+
+  struct header
+  {
+    /// The magic "OPUSRES", with the null character.
+    char magic[8];
+    boost::uint32_t version;
+    boost::uint32_t pad;
+
+    /// The text archive of the arguments, the graph and the tm.
+    section meta;
+    section edges;
+    section demands;
+    section hops;
+    section links;
+    section terms;
+    section coefs;
+  };
+
+  /**
+   * A link: an edge of the graph in one direction.  The edges are in
+   * the order of the edges function, every one first from its source
+   * to its target, and then back.
+   */
+  struct edge
+  {
+    boost::uint32_t source;
+    boost::uint32_t target;
+    /// True if there is a load, since calculate_ll skips idle links.
+    boost::uint32_t used;
+    boost::uint32_t pad;
+    /// The load as calculated by calculate_ll.
+    double load;
+  };
+
+  /// The demand from node src to node dst.
+  struct demand
+  {
+    boost::uint32_t dst;
+    boost::uint32_t src;
+    /// The rate of the demand in the traffic matrix.
+    double in_rate;
+    /// The rate of the packets delivered to node dst.
+    double out_rate;
+    /// The first hop of the demand, and the number of hops.
+    boost::uint64_t hop;
+    boost::uint64_t n_hops;
+  };
+
+  struct hop
+  {
+    boost::int64_t number;
+    /// The first link of the hop, and the number of links.
+    boost::uint64_t link;
+    boost::uint64_t n_links;
+  };
+
+  struct link
+  {
+    /// The index of the edge in the edge section.
+    boost::uint64_t edge;
+    /// The first term of the polynomial, and the number of terms.
+    boost::uint64_t term;
+    boost::uint64_t n_terms;
+  };
+
+  /// The kinds of distributions.
+  enum kind_t {NODISTRO, POISSON, GEOMETRIC, TABDISTRO};
+
+  /**
+   * The term of a polynomial.  The poisson and the geometric
+   * distributions have one coefficient, their parameter, while the
+   * tabdistro has the probabilities of the values from 0.
+   */
+  struct term
+  {
+    boost::uint64_t power;
+    boost::uint32_t kind;
+    boost::uint32_t pad;
+    /// The first coefficient, and the number of coefficients.
+    boost::uint64_t coef;
+    boost::uint64_t n_coefs;
+  };
+}
+
+/**
+ * Saves the results in the binary result archive.
+ *
+ * @return true on success
+ */
+bool
+save_result_archive(const string &name, const arguments &args,
+                    const Graph &g, const fp_matrix &tm,
+                    const pt_matrix &ptm);
+
+/**
+ * The reader of the binary result archive.  The file is mapped into
+ * memory, and the records are read in place.
+ */
+class result_archive
+{
+  boost::interprocess::file_mapping file;
+  boost::interprocess::mapped_region region;
+
+  /// The header in the mapped file, or null.
+  const ra::header *h;
+
+  /// Returns the records of the section.
+  template<typename T>
+  const T *records(const ra::section &s) const
+  {
+    return reinterpret_cast<const T *>
+      (static_cast<const char *>(region.get_address()) + s.offset);
+  }
+
+public:
+  result_archive();
+
+  /**
+   * Maps the file.  Returns false if the file can't be mapped, or
+   * if it's not a binary result archive of this version.
+   */
+  bool open(const string &name);
+
+  /**
+   * Loads the arguments, the graph and the traffic matrix.
+   */
+  void load_meta(arguments &args, Graph &g, fp_matrix &tm) const;
+
+  /**
+   * Returns the link loads the way calculate_ll does, but without
+   * loading the trajectories.
+   */
+  void load_ll(const Graph &g, map<Edge, double> &ll) const;
+
+  /**
+   * Returns the number of demands.
+   */
+  size_t demands() const;
+
+  /**
+   * Returns the k-th demand.
+   */
+  const ra::demand &demand(size_t k) const;
+
+  /**
+   * Loads the trajectory of the k-th demand.
+   */
+  void load_trajectory(const Graph &g, size_t k,
+                       packet_trajectory &pt) const;
+
+  /**
+   * Loads the whole packet trajectory matrix.
+   */
+  void load_ptm(const Graph &g, pt_matrix &ptm) const;
+};
+
+#endif /* RESULT_ARCHIVE_HPP */
@@ -0,0 +1,108 @@
+#include "result_reader.hpp"
+
+#include "graph_serialization.hpp"
+#include "result_archive.hpp"
+#include "utils.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/serialization/string.hpp>
+
+using namespace std;
+
+/**
+ * Reads the results from the binary result archive.
+ */
+static void
+read_binary(const result_archive &archive, arguments &args, Graph &g,
+            fp_matrix &tm, result_subscriber &s)
+{
+  archive.load_meta(args, g, tm);
+
+  {
+    map<Edge, double> ll;
+    archive.load_ll(g, ll);
+    for(map<Edge, double>::const_iterator i = ll.begin(); i != ll.end(); ++i)
+      s.link_load(i->first, i->second);
+  }
+
+  bool wants = s.wants_trajectories();
+
+  for(size_t k = 0; k < archive.demands(); ++k)
+    {
+      const ra::demand &d = archive.demand(k);
+      s.demand_rate(d.dst, d.src, d.in_rate, d.out_rate);
+
+      if (wants)
+        {
+          packet_trajectory pt;
+          archive.load_trajectory(g, k, pt);
+          s.trajectory(d.dst, d.src, pt);
+        }
+    }
+}
+
+/**
+ * Reads the results from the text archive.  The whole packet
+ * trajectory matrix is loaded, since the text archive can't be read
+ * partially.
+ */
+static bool
+read_text(const string &name, arguments &args, Graph &g, fp_matrix &tm,
+          result_subscriber &s)
+{
+  ifstream ifs(name.c_str());
+
+  if (!ifs)
+    {
+      cerr << "Can't open " << name << endl;
+      return false;
+    }
+
+  pt_matrix ptm;
+
+  boost::archive::text_iarchive ia(ifs);
+  ia.get_helper<graph_helper>().g = &g;
+  ia >> args;
+  ia >> g;
+  ia >> tm;
+  ia >> ptm;
+
+  {
+    map<Edge, double> ll;
+    calculate_ll(ptm, ll, g);
+    for(map<Edge, double>::const_iterator i = ll.begin(); i != ll.end(); ++i)
+      s.link_load(i->first, i->second);
+  }
+
+  bool wants = s.wants_trajectories();
+
+  FOREACH_MATRIX_ELEMENT(ptm, i, j, e, pt_matrix)
+    {
+      double in_rate = tm.exists(i, j) ? tm.at(i, j) : 0;
+      s.demand_rate(i, j, in_rate, calculate_delivered(e, i, g));
+
+      if (wants)
+        s.trajectory(i, j, e);
+    }
+
+  return true;
+}
+
+bool
+read_results(const string &name, arguments &args, Graph &g, fp_matrix &tm,
+             result_subscriber &s)
+{
+  result_archive archive;
+
+  if (archive.open(name))
+    {
+      read_binary(archive, args, g, tm, s);
+      return true;
+    }
+
+  return read_text(name, args, g, tm, s);
+}
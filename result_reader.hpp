@@ -0,0 +1,80 @@
+#ifndef RESULT_READER_HPP
+#define RESULT_READER_HPP
+
+#include "arguments.hpp"
+#include "graph.hpp"
+#include "matrixes.hpp"
+
+#include <string>
+
+using namespace std;
+
+/**
+ * The subscriber of the results read by the read_results function.
+ * Derive from it, and override the functions of the results you
+ * need.  The trajectories are decoded only if wants_trajectories
+ * returns true.
+ */
+class result_subscriber
+{
+public:
+  virtual ~result_subscriber()
+  {
+  }
+
+  /**
+   * Returns true if the trajectories of the demands should be passed
+   * to the trajectory function.
+   */
+  virtual bool
+  wants_trajectories() const
+  {
+    return false;
+  }
+
+  /**
+   * The load of a link, as calculated by calculate_ll.  Idle links
+   * are skipped.
+   */
+  virtual void
+  link_load(Edge e, double load)
+  {
+  }
+
+  /**
+   * The rates of the demand from node src to node dst: the rate in
+   * the traffic matrix, and the rate of the packets delivered.
+   */
+  virtual void
+  demand_rate(Vertex dst, Vertex src, double in_rate, double out_rate)
+  {
+  }
+
+  /**
+   * The trajectory of the demand from node src to node dst.
+   */
+  virtual void
+  trajectory(Vertex dst, Vertex src, const packet_trajectory &pt)
+  {
+  }
+};
+
+/**
+ * Reads the results from the binary result archive or from the text
+ * archive.  The arguments, the graph and the traffic matrix are
+ * returned, and the rest is passed to the subscriber.
+ *
+ * The binary result archive is read in place, and a trajectory is
+ * decoded only when the subscriber wants it.  The text archive has to
+ * be parsed in whole.
+ *
+ * The function doesn't use global state, and so archives can be read
+ * concurrently.
+ *
+ * @return true on success
+ */
+bool
+read_results(const string &name, arguments &args, Graph &g, fp_matrix &tm,
+             result_subscriber &s);
+
+#endif /* RESULT_READER_HPP */
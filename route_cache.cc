@@ -0,0 +1,86 @@
+#include "route_cache.hpp"
+
+#include <cassert>
+
+using namespace std;
+
+route_cache::route_cache(size_t capacity) :
+  capacity(capacity), nhits(0), nmisses(0)
+{
+  assert(capacity > 0);
+}
+
+route_cache::key_type
+route_cache::encode(const map<Vertex, int> &arr)
+{
+  key_type k;
+  k.reserve(2 * arr.size());
+
+  for(map<Vertex, int>::const_iterator i = arr.begin(); i != arr.end(); ++i)
+    {
+      k.push_back(i->first);
+      k.push_back(i->second);
+    }
+
+  return k;
+}
+
+const edge_count_map *
+route_cache::find(const key_type &k)
+{
+  index_type::iterator i = index.find(k);
+
+  if (i == index.end())
+    {
+      ++nmisses;
+      return 0;
+    }
+
+  ++nhits;
+
+  // Move the result to the front of the list.
+  lru.splice(lru.begin(), lru, i->second);
+
+  return &i->second->second;
+}
+
+void
+route_cache::insert(const key_type &k, const edge_count_map &c)
+{
+  assert(index.find(k) == index.end());
+
+  // Evict the least recently used result.
+  if (index.size() == capacity)
+    {
+      index.erase(lru.back().first);
+      lru.pop_back();
+    }
+
+  lru.push_front(make_pair(k, c));
+  index[k] = lru.begin();
+}
+
+size_t
+route_cache::size() const
+{
+  return index.size();
+}
+
+unsigned long
+route_cache::hits() const
+{
+  return nhits;
+}
+
+unsigned long
+route_cache::misses() const
+{
+  return nmisses;
+}
+
+double
+route_cache::hit_rate() const
+{
+  unsigned long n = nhits + nmisses;
+  return n ? double(nhits) / n : 0;
+}
@@ -0,0 +1,94 @@
+#ifndef ROUTE_CACHE_HPP
+#define ROUTE_CACHE_HPP
+
+#include "edge_probs.hpp"
+#include "graph.hpp"
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+using namespace std;
+
+/**
+ * The cache of the routing results of a node.  The result of routing
+ * an arrangement of packets at node j depends only on the
+ * arrangement, and the same arrangements come up over and over again
+ * in the analytical iterations.
+ *
+ * The cache is bounded: it keeps at most capacity results, and when
+ * it's full, the least recently used result is evicted.  The cache
+ * is used by one thread at a time.
+ */
+class route_cache
+{
+public:
+  /**
+   * The key of an arrangement: the destination nodes and the numbers
+   * of packets one after another, in the order of the nodes.
+   */
+  typedef vector<int> key_type;
+
+private:
+  /// The results from the most to the least recently used.
+  typedef list<pair<key_type, edge_count_map> > lru_type;
+  lru_type lru;
+
+  /// The results by the key.
+  typedef boost::unordered_map<key_type, lru_type::iterator> index_type;
+  index_type index;
+
+  /// The maximal number of results kept.
+  size_t capacity;
+
+  /// The numbers of hits and misses.
+  unsigned long nhits, nmisses;
+
+public:
+  /// The default capacity.
+  static const size_t default_capacity = 4096;
+
+  route_cache(size_t capacity = default_capacity);
+
+  /**
+   * Returns the key of arrangement arr.
+   */
+  static key_type
+  encode(const map<Vertex, int> &arr);
+
+  /**
+   * Returns the cached result for key k, or 0 if there is none.  The
+   * result becomes the most recently used.  The returned pointer is
+   * valid until the next insert.
+   */
+  const edge_count_map *
+  find(const key_type &k);
+
+  /**
+   * Caches result c for key k, which must not be cached yet.
+   */
+  void
+  insert(const key_type &k, const edge_count_map &c);
+
+  /// Returns the number of results kept.
+  size_t
+  size() const;
+
+  /// Returns the number of hits.
+  unsigned long
+  hits() const;
+
+  /// Returns the number of misses.
+  unsigned long
+  misses() const;
+
+  /// Returns the ratio of hits to all lookups, or 0 if no lookups.
+  double
+  hit_rate() const;
+};
+
+#endif /* ROUTE_CACHE_HPP */
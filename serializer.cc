@@ -1,4 +1,6 @@
 #include "serializer.hpp"
+#include "result_archive.hpp"
+
 #include <fstream>
 #include <sstream>
 
@@ -12,13 +14,19 @@ serializer::serializer(const arguments &args,
 }
 
 void
-serializer::operator()(const pt_matrix &ptm) const
+serializer::save(const string &name, const pt_matrix &ptm) const
 {
-  if (!args.output_filename.empty())
+  if (args.binary)
     {
-      ofstream out(args.output_filename.c_str());
+      if (!save_result_archive(name, args, g, tm, ptm))
+        cerr << "Can't save " << name << endl;
+    }
+  else
+    {
+      ofstream out(name.c_str());
 
       boost::archive::text_oarchive oa(out);
+      oa.get_helper<graph_helper>().g = &g;
       oa << args;
       oa << g;
       oa << tm;
@@ -26,6 +34,13 @@ serializer::operator()(const pt_matrix &ptm) const
     }
 }
 
+void
+serializer::operator()(const pt_matrix &ptm) const
+{
+  if (!args.output_filename.empty())
+    save(args.output_filename, ptm);
+}
+
 void
 serializer::operator()(const pt_matrix &ptm, int iter) const
 {
@@ -38,13 +53,7 @@ serializer::operator()(const pt_matrix &ptm, int iter) const
           name << args.output_filename;
           name << "_" << iter;
 
-          ofstream out(name.str().c_str());
-
-          boost::archive::text_oarchive oa(out);
-          oa << args;
-          oa << g;
-          oa << tm;
-          oa << ptm;
+          save(name.str(), ptm);
         }
     }
 }
@@ -6,12 +6,20 @@
 #include "graph_serialization.hpp"
 #include "matrixes.hpp"
 
+#include <string>
+
+/**
+ * Saves the results to the output file given in the arguments,
+ * either in the text archive, or in the binary result archive.
+ */
 class serializer
 {
   const arguments &args;
   const Graph &g;
   const fp_matrix &tm;
 
+  void save(const string &name, const pt_matrix &ptm) const;
+
 public:
   serializer(const arguments &args, const Graph &g, const fp_matrix &tm);
 
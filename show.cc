@@ -1,18 +1,15 @@
 #include "arguments.hpp"
 #include "show_args.hpp"
 #include "graph.hpp"
-#include "graph_serialization.hpp"
 #include "matrixes.hpp"
+#include "result_reader.hpp"
 #include "utils.hpp"
 #include "utils_ana.hpp"
 
 #include <cassert>
 #include <iostream>
-#include <fstream>
-#include <set>
-
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/serialization/string.hpp>
+#include <map>
+#include <vector>
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
@@ -67,43 +64,56 @@ check_ll(const map<Edge, double> &ll, const Graph &g, ostream &os,
     os << sqrt(accumulators::variance(acc_load)) << std::endl;
 }
 
+/**
+ * Collects the results to be shown: the link loads, the packet loss
+ * probabilities of the demands, and, if wanted, the trajectories.
+ */
+class show_subscriber: public result_subscriber
+{
+  bool wants;
+
+public:
+  map<Edge, double> ll;
+  vector<double> plps;
+  pt_matrix ptm;
+
+  show_subscriber(bool wants) : wants(wants)
+  {
+  }
+
+  bool
+  wants_trajectories() const
+  {
+    return wants;
+  }
+
+  void
+  link_load(Edge e, double load)
+  {
+    ll[e] = load;
+  }
+
+  void
+  demand_rate(Vertex dst, Vertex src, double in_rate, double out_rate)
+  {
+    assert(in_rate != 0);
+    plps.push_back((in_rate - out_rate) / in_rate);
+  }
+
+  void
+  trajectory(Vertex dst, Vertex src, const packet_trajectory &pt)
+  {
+    ptm[dst][src] = pt;
+  }
+};
+
 void
-check_plp(const pt_matrix &ptm, const fp_matrix &tm, const Graph &g,
-          ostream &os, const show_args &args)
+check_plp(const vector<double> &plps, ostream &os, const show_args &args)
 {
   accumulator_set<double, stats<tag::mean, tag::variance> > acc_plp;
 
-  // Iterate over all demands.  The element e is the packet trajectory
-  // for the packet which started at node j and that goes to node i.
-  FOREACH_MATRIX_ELEMENT(ptm, i, j, e, pt_matrix)
-    {
-      // Make sure that the rate of the demand is in the traffic
-      // matrix.
-      assert(tm.exists(i, j));
-      double in_rate = tm.at(i, j);
-      double out_rate = 0;
-      
-      // Iterate over the hops of a trajectory.
-      for(packet_trajectory::const_iterator t = e.begin();
-          t != e.end(); ++t)
-        // Iterate over the links of the hop.  Iterator l points to a
-        // pair of <Edge, dist_poly>.
-        for(packet_trajectory::mapped_type::const_iterator
-              l = t->second.begin(); l != t->second.end(); ++l)
-          {
-            // The node where the packet arrives along this link.
-            Vertex ld = target(l->first, g);
-
-            if (ld == i)
-              // The sum function is our function defined in the
-              // global name space.  There is also the sum function in
-              // the Boost.accumulators, but it's not what we want.
-              out_rate += ::sum(l->second).mean();
-          }
-
-      double plp = (in_rate - out_rate) / in_rate;
-      acc_plp(plp);
-    }
+  for(vector<double>::const_iterator i = plps.begin(); i != plps.end(); ++i)
+    acc_plp(*i);
 
   if (args.show_others)
     os << "Packet loss probability mean: ";
@@ -126,42 +136,27 @@ int main(int argc, char* argv[])
       return 1;
     }
 
-  const char *ifn = args.file_name.c_str();
-
   arguments a;
   Graph g;
   fp_matrix tm;
-  pt_matrix ptm;
 
-  ifstream ifs(ifn);
-
-  if(!ifs)
-    {
-      cerr << "Can't open " << ifn << endl;
-      return 1;
-    }
+  // The trajectories are decoded only to be shown.
+  show_subscriber s(args.show_others);
 
-  boost::archive::text_iarchive ia(ifs);
-  ia >> a;
-  ia >> g;
-  p_graph = &g;
-  ia >> tm;
-  ia >> ptm;
+  if (!read_results(args.file_name, a, g, tm, s))
+    return 1;
 
   if (args.show_others)
     print_input(g, tm, cout);
 
-  map<Edge, double> ll;
-  calculate_ll(ptm, ll, g);
-
   if (args.show_others)
-    print_ll(ll, g, cout);
+    print_ll(s.ll, g, cout);
 
   if (args.show_others)
-    print_ptm(ptm, g, cout);
+    print_ptm(s.ptm, g, cout);
 
-  check_ll(ll, g, cout, args);
-  check_plp(ptm, tm, g, cout, args);
+  check_ll(s.ll, g, cout, args);
+  check_plp(s.plps, cout, args);
 
   return 0;
 }
@@ -0,0 +1,236 @@
+#include "sim_stats.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+batch_counts::batch_counts() : offered(0), delivered(0)
+{
+}
+
+batch_counts &
+batch_counts::operator += (const batch_counts &bc)
+{
+  if (transits.size() < bc.transits.size())
+    transits.resize(bc.transits.size());
+
+  for(int i = 0; i < bc.transits.size(); ++i)
+    transits[i] += bc.transits[i];
+
+  offered += bc.offered;
+  delivered += bc.delivered;
+
+  return *this;
+}
+
+void
+batch_counts::clear()
+{
+  fill(transits.begin(), transits.end(), 0);
+  offered = 0;
+  delivered = 0;
+}
+
+sim_stats::sim_stats(const Graph &g, int HL, int DL) :
+  g(g), nv(num_vertices(g)), nh(HL + 1), nd(DL + 1)
+{
+  // Make sure the largest key, which is for a link, fits in 64 bits.
+  assert((double)nv * nv * nh * nv * nv * nd < 1.8e19);
+
+  batch.transits.resize(nv * nv);
+  admitted.resize(nv * nv);
+  rejected.resize(nv * nv);
+}
+
+boost::uint64_t
+sim_stats::key(const packet &pkt, boost::uint64_t loc,
+               boost::uint64_t nl) const
+{
+  // This is the delay the packet incurred in the network.
+  int delay = pkt.next_ts - pkt.start_ts;
+
+  assert(pkt.hops < nh);
+  assert(delay < nd);
+
+  boost::uint64_t k = pkt.dst;
+  k = k * nv + pkt.src;
+  k = k * nh + pkt.hops;
+  k = k * nl + loc;
+  k = k * nd + delay;
+
+  return k;
+}
+
+void
+sim_stats::report_presence(Vertex v, const packet &pkt)
+{
+  ppe.push_back(key(pkt, v, nv));
+}
+
+void
+sim_stats::report_transition(Edge e, const packet &pkt)
+{
+  // A link is given by its source and target, because the graph is
+  // undirected, and the edge descriptor tells the direction.
+  boost::uint64_t loc = source(e, g) * nv + target(e, g);
+  pte.push_back(key(pkt, loc, (boost::uint64_t)nv * nv));
+  ++batch.transits[loc];
+}
+
+void
+sim_stats::report_offered(int n)
+{
+  batch.offered += n;
+}
+
+void
+sim_stats::report_admitted(const packet &pkt)
+{
+  ++admitted[pkt.dst * nv + pkt.src];
+}
+
+void
+sim_stats::report_rejected(const packet &pkt)
+{
+  ++rejected[pkt.dst * nv + pkt.src];
+}
+
+void
+sim_stats::report_delivered(int n)
+{
+  batch.delivered += n;
+}
+
+void
+sim_stats::close(std::vector<boost::uint64_t> &events, histograms &h)
+{
+  // Now the same keys are next to each other.
+  sort(events.begin(), events.end());
+
+  std::vector<boost::uint64_t>::iterator i = events.begin();
+  while(i != events.end())
+    {
+      std::vector<boost::uint64_t>::iterator j = i;
+      while(j != events.end() && *j == *i)
+        ++j;
+
+      // The number of packets with the key.
+      int count = j - i;
+
+      std::vector<boost::uint32_t> &hist = h[*i];
+      if (hist.size() <= count)
+        hist.resize(count + 1);
+      ++hist[count];
+
+      i = j;
+    }
+
+  events.clear();
+}
+
+void
+sim_stats::close_slot()
+{
+  close(ppe, pph);
+  close(pte, pth);
+}
+
+void
+sim_stats::take_batch(batch_counts &bc)
+{
+  bc += batch;
+  batch.clear();
+}
+
+void
+sim_stats::clear()
+{
+  pph.clear();
+  pth.clear();
+  fill(admitted.begin(), admitted.end(), 0);
+  fill(rejected.begin(), rejected.end(), 0);
+}
+
+void
+sim_stats::add(histograms &h1, const histograms &h2)
+{
+  for(histograms::const_iterator i = h2.begin(); i != h2.end(); ++i)
+    {
+      std::vector<boost::uint32_t> &hist = h1[i->first];
+      if (hist.size() < i->second.size())
+        hist.resize(i->second.size());
+
+      for(int c = 0; c < i->second.size(); ++c)
+        hist[c] += i->second[c];
+    }
+}
+
+sim_stats &
+sim_stats::operator += (const sim_stats &s)
+{
+  assert(nv == s.nv && nh == s.nh && nd == s.nd);
+
+  add(pph, s.pph);
+  add(pth, s.pth);
+
+  for(int i = 0; i < admitted.size(); ++i)
+    {
+      admitted[i] += s.admitted[i];
+      rejected[i] += s.rejected[i];
+    }
+
+  batch += s.batch;
+
+  return *this;
+}
+
+void
+sim_stats::get_ppcmm(ppcm_matrix &ppcmm) const
+{
+  for(histograms::const_iterator i = pph.begin(); i != pph.end(); ++i)
+    {
+      // Decode the key.
+      boost::uint64_t k = i->first;
+      int delay = k % nd; k /= nd;
+      Vertex v = k % nv; k /= nv;
+      int hop = k % nh; k /= nh;
+      Vertex src = k % nv; k /= nv;
+      Vertex dst = k;
+
+      count_map_poly::mapped_type &cm = ppcmm[dst][src][hop][v][delay];
+      for(int c = 1; c < i->second.size(); ++c)
+        if (i->second[c])
+          cm[c] += i->second[c];
+    }
+}
+
+void
+sim_stats::get_ptcmm(ptcm_matrix &ptcmm) const
+{
+  boost::uint64_t ne = (boost::uint64_t)nv * nv;
+
+  for(histograms::const_iterator i = pth.begin(); i != pth.end(); ++i)
+    {
+      // Decode the key.
+      boost::uint64_t k = i->first;
+      int delay = k % nd; k /= nd;
+      boost::uint64_t loc = k % ne; k /= ne;
+      int hop = k % nh; k /= nh;
+      Vertex src = k % nv; k /= nv;
+      Vertex dst = k;
+
+      Edge e = edge(loc / nv, loc % nv, g).first;
+
+      count_map_poly::mapped_type &cm = ptcmm[dst][src][hop][e][delay];
+      for(int c = 1; c < i->second.size(); ++c)
+        if (i->second[c])
+          cm[c] += i->second[c];
+    }
+}
+
+void
+sim_stats::get_admissions(adm_matrix &am) const
+{
+  for(int i = 0; i < admitted.size(); ++i)
+    if (admitted[i] || rejected[i])
+      am[i / nv][i % nv] = std::make_pair(admitted[i], rejected[i]);
+}
@@ -0,0 +1,235 @@
+#ifndef SIM_STATS_HPP
+#define SIM_STATS_HPP
+
+#include "graph.hpp"
+#include "matrixes.hpp"
+#include "packet.hpp"
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/unordered_map.hpp>
+
+/**
+ * The counts of a batch of time slots.  We use them to tell whether
+ * the simulation converged.
+ */
+struct batch_counts
+{
+  /// The number of packets that traversed links.  The link from
+  /// node s to node t has index s * nv + t, where nv is the number of
+  /// vertexes.
+  std::vector<boost::uint64_t> transits;
+
+  /// The number of packets that asked for admission.
+  boost::uint64_t offered;
+
+  /// The number of packets delivered to their destinations.
+  boost::uint64_t delivered;
+
+  batch_counts();
+
+  batch_counts &operator += (const batch_counts &);
+
+  /// Zeroes the counts.
+  void clear();
+};
+
+/**
+ * The statistics of the simulation.  It's the compact counterpart of
+ * the ppcm_matrix and ptcm_matrix structures.
+ *
+ * A packet event, i.e. a presence of a packet at a node or a
+ * transition of a packet along a link, is described by a single
+ * integer key, which we get with index arithmetic over [dst][src]
+ * [hop][vertex or edge][delay], where the ranges are given by the
+ * graph, the hop limit and the distance limit.  For every key there
+ * is a flat histogram: element c of the histogram is the number of
+ * time slots in which exactly c packets had that key.
+ *
+ * The events of a node are reported during the time slot, and then
+ * the time slot is closed with the close_slot function, which adds
+ * the events to the histograms.
+ */
+class sim_stats
+{
+  friend class boost::serialization::access;
+
+  const Graph &g;
+
+  /// The number of vertexes, hops and delays.
+  int nv, nh, nd;
+
+  /// The histograms indexed with keys.
+  typedef boost::unordered_map<boost::uint64_t,
+                               std::vector<boost::uint32_t> > histograms;
+
+  /// The histograms of packet presence and packet trajectory.
+  histograms pph, pth;
+
+  /// The keys of the events of the current time slot.
+  std::vector<boost::uint64_t> ppe, pte;
+
+  /// The counts of the current batch.
+  batch_counts batch;
+
+  /// The numbers of packets admitted and rejected per demand.  The
+  /// demand from node src to node dst has index dst * nv + src.
+  std::vector<boost::uint64_t> admitted, rejected;
+
+  /// Returns the key of the demand, the hop and the delay of pkt
+  /// with the location loc out of nl locations.
+  boost::uint64_t key(const packet &pkt, boost::uint64_t loc,
+                      boost::uint64_t nl) const;
+
+  /// Counts the same keys in events, and adds the counts to h.
+  static void close(std::vector<boost::uint64_t> &events, histograms &h);
+
+  /// Adds the histograms h2 to the histograms h1.
+  static void add(histograms &h1, const histograms &h2);
+
+  /// Saves the histograms as their number followed by the pairs.
+  template<class Archive>
+  static void save_histograms(Archive &ar, const histograms &h)
+  {
+    boost::uint64_t n = h.size();
+    ar << n;
+    for(histograms::const_iterator i = h.begin(); i != h.end(); ++i)
+      {
+        ar << i->first;
+        ar << i->second;
+      }
+  }
+
+  /// Loads the histograms saved with save_histograms.
+  template<class Archive>
+  static void load_histograms(Archive &ar, histograms &h)
+  {
+    boost::uint64_t n;
+    ar >> n;
+    h.clear();
+    while(n--)
+      {
+        boost::uint64_t k;
+        ar >> k;
+        ar >> h[k];
+      }
+  }
+
+  /**
+   * Saves the counts, but not the events of the current time slot,
+   * and so the time slot has to be closed.  The graph and the limits
+   * are not saved, and so the object has to be loaded for the same.
+   */
+  template<class Archive>
+  void save(Archive &ar, const unsigned int) const
+  {
+    save_histograms(ar, pph);
+    save_histograms(ar, pth);
+    ar << batch.transits;
+    ar << batch.offered;
+    ar << batch.delivered;
+    ar << admitted;
+    ar << rejected;
+  }
+
+  template<class Archive>
+  void load(Archive &ar, const unsigned int)
+  {
+    load_histograms(ar, pph);
+    load_histograms(ar, pth);
+    ar >> batch.transits;
+    ar >> batch.offered;
+    ar >> batch.delivered;
+    ar >> admitted;
+    ar >> rejected;
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+public:
+  /**
+   * @param g the graph
+   *
+   * @param HL the hop limit
+   *
+   * @param DL the distance limit
+   */
+  sim_stats(const Graph &g, int HL, int DL);
+
+  /**
+   * Reports that packet pkt is present at node v.
+   */
+  void report_presence(Vertex v, const packet &pkt);
+
+  /**
+   * Reports that packet pkt transits along link e.
+   */
+  void report_transition(Edge e, const packet &pkt);
+
+  /**
+   * Reports that n packets asked for admission.
+   */
+  void report_offered(int n);
+
+  /**
+   * Reports that packet pkt was admitted at its source node.
+   */
+  void report_admitted(const packet &pkt);
+
+  /**
+   * Reports that packet pkt was rejected at its source node.
+   */
+  void report_rejected(const packet &pkt);
+
+  /**
+   * Reports that n packets were delivered to their destinations.
+   */
+  void report_delivered(int n);
+
+  /**
+   * Closes the time slot of a node: adds the events reported since
+   * the last call to the histograms.
+   */
+  void close_slot();
+
+  /**
+   * Moves the counts of the current batch to bc, and starts a new
+   * batch.  The counts are added to bc.
+   */
+  void take_batch(batch_counts &bc);
+
+  /**
+   * Discards the histograms and the admission counts, but not the
+   * counts of the current batch.  We use it to discard the warm-up
+   * period.
+   */
+  void clear();
+
+  /**
+   * Adds the histograms, the admission counts and the counts of the
+   * current batch of another object.  We use it to merge the
+   * statistics of simulation threads and replications.
+   */
+  sim_stats &operator += (const sim_stats &);
+
+  /**
+   * Converts the statistics to the ppcm_matrix structure.
+   */
+  void get_ppcmm(ppcm_matrix &ppcmm) const;
+
+  /**
+   * Converts the statistics to the ptcm_matrix structure.
+   */
+  void get_ptcmm(ptcm_matrix &ptcmm) const;
+
+  /**
+   * Returns the admission counts of the demands that offered packets.
+   */
+  void get_admissions(adm_matrix &am) const;
+};
+
+#endif /* SIM_STATS_HPP */
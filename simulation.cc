@@ -1,26 +1,640 @@
 #include "simulation.hpp"
+#include "batch_means.hpp"
+#include "checkpoint.hpp"
 #include "config.hpp"
+#include "demand_table.hpp"
 #include "generate.hpp"
-#include "rand.hpp"
+#include "parallel.hpp"
 #include "utils_sim.hpp"
 #include "utils.hpp"
 
-#include <gsl/gsl_rng.h>
-#include <gsl/gsl_randist.h>
-
 #include <ctime>
 #include <set>
+#include <sstream>
 #include <vector>
 
-#include <boost/progress.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/ref.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
+/**
+ * The default number of time slots of a simulation.
+ */
 #define TS_LIMIT 100000
 
+/**
+ * The number of time slots of a batch, after which we check whether
+ * the simulation converged.
+ */
+#define BATCH_SIZE 1000
+
+/**
+ * The confidence level of the intervals of link loads.
+ */
+#define CI_LEVEL 0.95
+
 using namespace std;
 
-boost::tuple<pp_matrix, pt_matrix>
-sim_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
-             ostream &os)
+/**
+ * Decides when the simulation stops.  Without the precision, the
+ * simulation runs max_slots time slots.  With the precision, the
+ * statistics are checked at the end of every batch with the
+ * batch_means object, and the simulation stops when it converged, or
+ * after max_slots time slots.  The statistics of the warm-up period
+ * are discarded.
+ */
+class sim_monitor
+{
+  friend class boost::serialization::access;
+
+  /// Only the state is serialized, since the rest is given by the
+  /// arguments of the constructor.
+  template<class Archive>
+  void serialize(Archive &ar, const unsigned int)
+  {
+    ar & bm;
+    ar & first;
+    ar & end;
+  }
+
+  double precision;
+  timeslot max_slots;
+  batch_means bm;
+
+  /// The statistics of the threads.
+  vector<sim_stats *> stats;
+
+  /// The first time slot counted in the statistics.
+  timeslot first;
+
+  /// The time slot after the last simulated time slot.
+  timeslot end;
+
+public:
+  sim_monitor(const Graph &g, double precision, timeslot max_slots) :
+    precision(precision), max_slots(max_slots),
+    bm(g, precision, BATCH_SIZE, CI_LEVEL), first(0), end(max_slots)
+  {
+  }
+
+  /**
+   * Makes the monitor watch the statistics of a thread.
+   */
+  void watch(sim_stats *s)
+  {
+    stats.push_back(s);
+  }
+
+  /**
+   * Returns true if time slot ts ends a batch to check.
+   */
+  bool batch_end(timeslot ts) const
+  {
+    return precision > 0 && (ts + 1) % BATCH_SIZE == 0;
+  }
+
+  /**
+   * Checks the batch that ends with time slot ts.  No thread can
+   * touch the statistics at this time.
+   */
+  void check(timeslot ts)
+  {
+    batch_counts bc;
+    for(int i = 0; i < stats.size(); ++i)
+      stats[i]->take_batch(bc);
+
+    if (bm.add(bc))
+      {
+        // The warm-up period is over: start counting anew.
+        for(int i = 0; i < stats.size(); ++i)
+          stats[i]->clear();
+        first = ts + 1;
+      }
+
+    if (bm.converged())
+      end = ts + 1;
+  }
+
+  /**
+   * Returns true if time slot ts is to be simulated.
+   */
+  bool simulate(timeslot ts) const
+  {
+    return ts < end;
+  }
+
+  /**
+   * Adds the statistics of the threads to s.  No thread can touch the
+   * statistics at this time.
+   */
+  void merge(sim_stats &s) const
+  {
+    for(int i = 0; i < stats.size(); ++i)
+      s += *stats[i];
+  }
+
+  /**
+   * Returns the time slot after the last simulated time slot.
+   */
+  timeslot ended() const
+  {
+    return end;
+  }
+
+  /**
+   * Returns the number of time slots the statistics were collected
+   * for.
+   */
+  timeslot counted() const
+  {
+    return end - first;
+  }
+
+  /**
+   * Returns the number of time slots that were not simulated.
+   */
+  timeslot skipped() const
+  {
+    return max_slots - end;
+  }
+};
+
+/**
+ * The checkpoints of a replication.  A checkpoint is the state of the
+ * replication before a time slot: the packets in flight, the
+ * statistics, the monitor and, in the event mode, the time slots in
+ * which the nodes generate packets next.  The random numbers have no
+ * state, since they are given by the seed, the node and the time
+ * slot, and so a replication resumed from a checkpoint continues
+ * exactly as it would have without the break.
+ *
+ * The statistics of the threads are saved merged, and are loaded for
+ * a single thread.  They are only ever added up, and so a replication
+ * can be resumed with a different number of threads.
+ */
+class sim_checkpoint
+{
+  const Graph &g;
+  int HL, DL;
+  double precision;
+  timeslot max_slots;
+  bool events;
+
+  /// The name of the checkpoint file, or empty for none.
+  string name;
+
+  /// The number of time slots between checkpoints.
+  int interval;
+
+  checkpoint_writer &writer;
+
+public:
+  sim_checkpoint(const Graph &g, int HL, int DL, double precision,
+                 timeslot max_slots, bool events, const string &name,
+                 int interval, checkpoint_writer &writer) :
+    g(g), HL(HL), DL(DL), precision(precision), max_slots(max_slots),
+    events(events), name(name), interval(interval), writer(writer)
+  {
+  }
+
+  /**
+   * Returns the name of the checkpoint file.
+   */
+  const string &get_name() const
+  {
+    return name;
+  }
+
+  /**
+   * Returns true if the checkpoints are saved.
+   */
+  bool enabled() const
+  {
+    return !name.empty();
+  }
+
+  /**
+   * Returns true if a checkpoint is due after time slot ts.
+   */
+  bool due(timeslot ts) const
+  {
+    return enabled() && (ts + 1) % interval == 0;
+  }
+
+  /**
+   * Saves the checkpoint before time slot ts.  The checkpoint is
+   * serialized by the calling thread, and written in the background.
+   * No thread can touch the state at this time.
+   *
+   * @param stats the statistics of all threads
+   *
+   * @param next_gen the next generating time slots of the nodes, or
+   * empty in the time-slot mode
+   */
+  void save(timeslot ts, unsigned long seed,
+            const vector<calendar_queue> &pqv, const sim_stats &stats,
+            const sim_monitor &monitor,
+            const vector<timeslot> &next_gen) const;
+
+  /**
+   * Loads the checkpoint, which has to be of a replication with the
+   * same graph and parameters.  The packets are taken from the pool
+   * and put into the queues, and the statistics are added to stats.
+   * Nothing is changed if the checkpoint can't be loaded.
+   *
+   * @param ts the time slot to resume with
+   *
+   * @param seed the seed of the replication
+   *
+   * @return true on success
+   */
+  bool load(timeslot &ts, unsigned long &seed, vector<calendar_queue> &pqv,
+            packet_pool &pool, sim_stats &stats, sim_monitor &monitor,
+            vector<timeslot> &next_gen) const;
+};
+
+void
+sim_checkpoint::save(timeslot ts, unsigned long seed,
+                     const vector<calendar_queue> &pqv,
+                     const sim_stats &stats, const sim_monitor &monitor,
+                     const vector<timeslot> &next_gen) const
+{
+  ostringstream str;
+
+  {
+    boost::archive::binary_oarchive oa(str);
+
+    // The parameters that have to be the same when resuming.
+    int nv = num_vertices(g);
+    oa << nv << HL << DL << precision << max_slots << events;
+
+    oa << seed << ts;
+
+    // The packets in flight, node by node, in the order of the
+    // queues, so that they are loaded into the same queues.
+    for(int v = 0; v < nv; ++v)
+      {
+        slot_pkts pkts;
+        pqv[v].packets(pkts);
+
+        int n = pkts.size();
+        oa << n;
+
+        for(slot_pkts::iterator i = pkts.begin(); i != pkts.end(); ++i)
+          {
+            const packet &pkt = **i;
+            oa << pkt.src << pkt.dst << pkt.start_ts << pkt.next_ts
+               << pkt.hops;
+          }
+      }
+
+    oa << stats << monitor << next_gen;
+  }
+
+  string data = str.str();
+  writer.write(name, data);
+}
+
+bool
+sim_checkpoint::load(timeslot &ts, unsigned long &seed,
+                     vector<calendar_queue> &pqv, packet_pool &pool,
+                     sim_stats &stats, sim_monitor &monitor,
+                     vector<timeslot> &next_gen) const
+{
+  string data;
+
+  if (!read_checkpoint(name, data))
+    return false;
+
+  // The state is loaded here first, and taken only when the whole
+  // checkpoint was loaded.
+  int nv = num_vertices(g);
+  timeslot cts;
+  unsigned long cseed;
+  vector<vector<packet> > pkts(nv);
+  sim_stats cstats(g, HL, DL);
+  sim_monitor cmonitor(g, precision, max_slots);
+  vector<timeslot> cnext_gen;
+
+  try
+    {
+      istringstream str(data);
+      boost::archive::binary_iarchive ia(str);
+
+      int cnv, cHL, cDL;
+      double cprecision;
+      timeslot cmax_slots;
+      bool cevents;
+      ia >> cnv >> cHL >> cDL >> cprecision >> cmax_slots >> cevents;
+
+      if (cnv != nv || cHL != HL || cDL != DL || cprecision != precision ||
+          cmax_slots != max_slots || cevents != events)
+        return false;
+
+      ia >> cseed >> cts;
+
+      for(int v = 0; v < nv; ++v)
+        {
+          int n;
+          ia >> n;
+
+          while(n--)
+            {
+              Vertex src, dst;
+              timeslot start_ts, next_ts;
+              int hops;
+              ia >> src >> dst >> start_ts >> next_ts >> hops;
+
+              if (src >= nv || dst >= nv)
+                return false;
+
+              packet pkt(src, dst, start_ts);
+              pkt.next_ts = next_ts;
+              pkt.hops = hops;
+              pkts[v].push_back(pkt);
+            }
+        }
+
+      ia >> cstats >> cmonitor >> cnext_gen;
+    }
+  catch(const boost::archive::archive_exception &)
+    {
+      return false;
+    }
+
+  ts = cts;
+  seed = cseed;
+
+  for(int v = 0; v < nv; ++v)
+    for(vector<packet>::iterator i = pkts[v].begin(); i != pkts[v].end(); ++i)
+      {
+        packet *pkt = pool.alloc(i->src, i->dst, i->start_ts);
+        pkt->next_ts = i->next_ts;
+        pkt->hops = i->hops;
+        pqv[v].insert(pkt);
+      }
+
+  stats += cstats;
+  monitor = cmonitor;
+  next_gen.swap(cnext_gen);
+
+  return true;
+}
+
+/**
+ * The packets sent between threads.  Element [p][s][d] keeps the
+ * packets that thread s sent to the nodes of thread d in a time slot
+ * of parity p.  We need two time slots, because a thread can already
+ * send packets in the next time slot, while other threads are still
+ * receiving packets of the previous time slot.
+ */
+typedef vector<vector<vector<sent_pkts> > > exchange_buffers;
+
+/**
+ * The simulation thread.  A thread owns the nodes from first to
+ * (last - 1), i.e. it simulates these nodes, and it is the only
+ * thread that touches their queues.  Packets sent to the nodes of
+ * other threads go through the exchange buffers.
+ */
+class sim_worker
+{
+  const Graph &g;
+  const demand_table &dt;
+  int HL, DL;
+
+  /// The number of this thread.
+  int w;
+
+  /// The nodes of this thread.
+  Vertex first, last;
+
+  /// The element owner[v] is the thread that owns node v.
+  const vector<int> &owner;
+
+  vector<calendar_queue> &pqv;
+
+  /// The seed of the random number streams.
+  unsigned long seed;
+
+  /// The first time slot to simulate.
+  timeslot start;
+
+  const sim_checkpoint &cp;
+
+  exchange_buffers &xb;
+  pool_balancer &pb;
+  boost::barrier &bar;
+  parallel_progress &progress;
+  sim_monitor &monitor;
+
+  /// The packets created and destroyed by this thread.
+  packet_pool pool;
+
+public:
+  /// The statistics of the nodes of this thread.
+  sim_stats stats;
+
+  sim_worker(const Graph &g, const demand_table &dt, int HL, int DL,
+             int w, Vertex first, Vertex last, const vector<int> &owner,
+             vector<calendar_queue> &pqv, unsigned long seed,
+             timeslot start, const sim_checkpoint &cp,
+             exchange_buffers &xb, pool_balancer &pb, boost::barrier &bar,
+             parallel_progress &progress, sim_monitor &monitor) :
+    g(g), dt(dt), HL(HL), DL(DL), w(w), first(first), last(last),
+    owner(owner), pqv(pqv), seed(seed), start(start), cp(cp), xb(xb),
+    pb(pb), bar(bar), progress(progress), monitor(monitor),
+    stats(g, HL, DL)
+  {
+  }
+
+  void operator()()
+  {
+    sent_pkts sent;
+
+    for (timeslot ts = start; monitor.simulate(ts); ts++)
+      {
+        // Receive the packets that were sent to our nodes in the
+        // previous time slot.  We take them in the order of the
+        // sending threads, which sent them in the order of the
+        // nodes, and so the packets land in the queues in exactly
+        // the order of the single-threaded simulation.
+        if (ts > start)
+          for (int s = 0; s < xb[0].size(); ++s)
+            deliver_pkts(xb[(ts - 1) % 2][s][w], pqv);
+
+        // Take the free packets that the other threads handed over.
+        pb.take(w, ts, pool);
+
+        for (Vertex j = first; j < last; ++j)
+          {
+            simulate_node(g, j, ts, dt, pqv[j], sent, seed, pool,
+                          stats, HL, DL);
+
+            for(sent_pkts::iterator i = sent.begin(); i != sent.end(); ++i)
+              xb[ts % 2][w][owner[i->first]].push_back(*i);
+            sent.clear();
+          }
+
+        // Hand over the free packets that we don't need, so that
+        // they don't pile up in our pool, when we receive more
+        // packets than we send.
+        pb.give(w, ts, pool);
+
+        bar.wait();
+
+        if (!w)
+          ++progress;
+
+        // At the end of a batch the first thread checks the
+        // statistics, while the other threads wait.
+        if (monitor.batch_end(ts))
+          {
+            if (!w)
+              monitor.check(ts);
+            bar.wait();
+          }
+
+        // For a checkpoint we receive the packets of this time slot
+        // already, so that the queues have all the packets in flight.
+        // There is nothing left to receive in the next time slot.
+        if (cp.due(ts))
+          {
+            for (int s = 0; s < xb[0].size(); ++s)
+              deliver_pkts(xb[ts % 2][s][w], pqv);
+            bar.wait();
+
+            if (!w)
+              {
+                sim_stats all(g, HL, DL);
+                monitor.merge(all);
+                cp.save(ts + 1, seed, pqv, all, monitor, vector<timeslot>());
+              }
+            bar.wait();
+          }
+      }
+  }
+};
+
+/**
+ * Runs the simulation in the event mode on a single thread.  A node
+ * is simulated in a time slot only if it's scheduled then: either it
+ * generates packets, or packets arrive at it.  The nodes of a time
+ * slot are simulated in the order of the nodes, as in the time-slot
+ * mode.  The idle time slots are only counted.
+ *
+ * @param start the first time slot to simulate
+ *
+ * @param next_gen the next generating time slots of the nodes, or
+ * empty to draw them anew
+ */
+static void
+simulate_events(const Graph &g, const demand_table &dt, int HL, int DL,
+                unsigned long seed, timeslot start,
+                const sim_checkpoint &cp, vector<calendar_queue> &pqv,
+                packet_pool &pool, vector<timeslot> &next_gen,
+                sim_monitor &monitor, sim_stats &stats,
+                parallel_progress &progress)
+{
+  // The scheduled nodes, in the order of time slots and nodes.
+  set<pair<timeslot, Vertex> > events;
+
+  // The element next_gen[j] is the next time slot in which node j
+  // generates packets.
+  if (next_gen.empty())
+    {
+      next_gen.resize(num_vertices(g));
+
+      BGL_FORALL_VERTICES(j, g, Graph)
+        {
+          stream_rng rng(seed, j, start, stream_rng::GAP);
+          next_gen[j] = dt.next_active(j, start, rng);
+        }
+    }
+
+  BGL_FORALL_VERTICES(j, g, Graph)
+    {
+      if (next_gen[j] != demand_table::never)
+        events.insert(make_pair(next_gen[j], j));
+
+      // The nodes with packets on their way, when resuming.
+      slot_pkts pkts;
+      pqv[j].packets(pkts);
+      for(slot_pkts::iterator i = pkts.begin(); i != pkts.end(); ++i)
+        events.insert(make_pair((*i)->next_ts, j));
+    }
+
+  // The packets that a node sends.
+  sent_pkts sent;
+
+  monitor.watch(&stats);
+
+  for (timeslot ts = start; monitor.simulate(ts); ts++)
+    {
+      // Simulate the nodes scheduled for this time slot.  A node
+      // scheduled many times is simulated once.
+      while(!events.empty() && events.begin()->first == ts)
+        {
+          Vertex j = events.begin()->second;
+          events.erase(events.begin());
+
+          bool gen = next_gen[j] == ts;
+          simulate_node(g, j, ts, dt, pqv[j], sent, seed, pool,
+                        stats, HL, DL, gen ? gen_active : gen_none);
+
+          // Draw the next time slot in which node j generates.
+          if (gen)
+            {
+              stream_rng rng(seed, j, ts + 1, stream_rng::GAP);
+              next_gen[j] = dt.next_active(j, ts + 1, rng);
+              if (next_gen[j] != demand_table::never)
+                events.insert(make_pair(next_gen[j], j));
+            }
+
+          // The nodes the packets were sent to process them when
+          // they arrive.
+          for(sent_pkts::iterator i = sent.begin(); i != sent.end(); ++i)
+            events.insert(make_pair(i->second->next_ts, i->first));
+
+          deliver_pkts(sent, pqv);
+        }
+
+      // Skip the idle time slots up to the next event, but stop at
+      // the end of a batch to check it, and at a checkpoint.
+      timeslot next = events.empty() ? demand_table::never :
+        events.begin()->first;
+
+      while(ts + 1 < next && monitor.simulate(ts + 1) &&
+            !monitor.batch_end(ts) && !cp.due(ts))
+        {
+          ++progress;
+          ++ts;
+        }
+
+      ++progress;
+
+      if (monitor.batch_end(ts))
+        monitor.check(ts);
+
+      if (cp.due(ts))
+        cp.save(ts + 1, seed, pqv, stats, monitor, next_gen);
+    }
+}
+
+/**
+ * Runs a single replication of the simulation with the given number
+ * of threads, and adds the counts to stats.  The replication saves
+ * its checkpoints with cp, and resumes from the last one if asked.
+ *
+ * @return the number of time slots the counts were collected for
+ */
+timeslot
+simulate(const Graph &g, const demand_table &dt, int HL, int DL,
+         int threads, unsigned long seed, double precision,
+         timeslot max_slots, bool events, const sim_checkpoint &cp,
+         bool resume, sim_stats &stats, parallel_progress &progress)
 {
   // The simulation operates on packet pointers.  A packet is created
   // at the source node (with the new operator) and is destroyed (with
@@ -32,73 +646,310 @@ sim_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
   //
   // - delivery to the destination node.
 
-  // GSL random number generator
-  const gsl_rng_type *T_rng;
-  gsl_rng *rng;
-  gsl_rng_env_setup();
-  T_rng = gsl_rng_default;
-  rng = gsl_rng_alloc(T_rng);
-  gsl_rng_set (rng, 0);
+  assert(threads >= 1);
 
-  // The number of packets that visit nodes.
-  ppcm_matrix ppcmm;
+  // This is a vector of packet queues.  Each node has ist own queue,
+  // that stores packets that will arrive to this node.  Packets in
+  // the queues are kept in buckets of their next_ts field.
+  vector<calendar_queue> pqv(num_vertices(g),
+                             calendar_queue(get_max_link_distance(g) + 1));
 
-  // The number of packets that traverse links.
-  ptcm_matrix ptcmm;
+  // Tells when to stop.
+  sim_monitor monitor(g, precision, max_slots);
 
-  // This is a map of packet queues.  Each node has ist own queue,
-  // that stores packets that will arrive to this node.  Packets in
-  // sets will be sorted based on their next_ts field.
-  map<Vertex, waiting_pkts> pqv;
+  // The packets of the single-threaded simulation, and of the
+  // checkpoint.  The pool has to outlive the threads, which release
+  // the packets of the checkpoint to their own pools.
+  packet_pool pool;
 
-  progress_display progress(TS_LIMIT, os);
+  // The first time slot to simulate, the statistics of the
+  // checkpoint, and the next generating time slots in the event mode.
+  timeslot start = 0;
+  sim_stats restored(g, HL, DL);
+  vector<timeslot> next_gen;
 
-  // In every iteration of this loop we simulate the behaviour of the
-  // network for this specific timeslot ts.
-  for (timeslot ts = 0; ts < TS_LIMIT; ts++)
+  if (resume && !cp.load(start, seed, pqv, pool, restored, monitor,
+                         next_gen))
+    cerr << "Can't resume from " << cp.get_name() << ", starting anew."
+         << endl;
+
+  progress += start;
+
+  // The threads of the simulation.
+  vector<sim_worker *> workers;
+
+  // There is no point in having threads without nodes.
+  int nt = min<int>(threads, num_vertices(g));
+
+  if (events)
     {
-      // Here we will process every node j separately.  The j node is
-      // the "current node" at which we process packets.  Packets are
-      // sent to the i node.
-      BGL_FORALL_VERTICES(j, g, Graph)
+      stats += restored;
+      simulate_events(g, dt, HL, DL, seed, start, cp, pqv, pool, next_gen,
+                      monitor, stats, progress);
+    }
+  else if (nt <= 1)
+    {
+      // The packets that a node sends.
+      sent_pkts sent;
+
+      stats += restored;
+      monitor.watch(&stats);
+
+      // In every iteration of this loop we simulate the behaviour of
+      // the network for this specific timeslot ts.
+      for (timeslot ts = start; monitor.simulate(ts); ts++)
+        {
+          // Here we process every node j separately.  The j node is
+          // the "current node" at which we process packets.  Packets
+          // are sent to the i node.
+          BGL_FORALL_VERTICES(j, g, Graph)
+            {
+              simulate_node(g, j, ts, dt, pqv[j], sent, seed, pool,
+                            stats, HL, DL);
+              deliver_pkts(sent, pqv);
+            }
+
+          ++progress;
+
+          if (monitor.batch_end(ts))
+            monitor.check(ts);
+
+          if (cp.due(ts))
+            cp.save(ts + 1, seed, pqv, stats, monitor, next_gen);
+        }
+    }
+  else
+    {
+      // The packets sent between the threads.
+      exchange_buffers xb(2, vector<vector<sent_pkts> >
+                          (nt, vector<sent_pkts>(nt)));
+
+      // The free packets handed over between the threads.
+      pool_balancer pb(nt);
+
+      boost::barrier bar(nt);
+
+      // Assign the threads contiguous ranges of nodes of about the
+      // same size.
+      int N = num_vertices(g);
+      vector<int> owner(N);
+
+      for (int w = 0; w < nt; ++w)
         {
-          // These are the local packets that ask for admission.
-          waiting_pkts local_add;
-
-          // These are the packets for which this packet is the
-          // destination.
-          waiting_pkts local_drop;
-
-          // We generate the local packets that ask for admission.  We
-          // randomly choose them, and repeat this process for all the
-          // destination nodes i.
-          BGL_FORALL_VERTICES(i, g, Graph)
-            fill_local_add(local_add, j, i, ts, tm, rng);
-
-          // This function does all the packet processing.
-          process_packets(g, j, ts, pqv, local_add, local_drop,
-                          ppcmm, ptcmm, HL, DL);
-
-          // Here we process the packets that asked for admission, but
-          // were jilted.  We simply delete them.
-          delete_waiting_pkts(local_add);
-
-          // Here we process the packets that are arriving at the
-          // destination, i.e. packets that we find in local_drop.
-          delete_waiting_pkts(local_drop);
+          Vertex first = w * N / nt;
+          Vertex last = (w + 1) * N / nt;
+
+          for (Vertex v = first; v < last; ++v)
+            owner[v] = w;
+
+          workers.push_back(new sim_worker(g, dt, HL, DL, w, first, last,
+                                           owner, pqv, seed, start, cp,
+                                           xb, pb, bar, progress,
+                                           monitor));
+          monitor.watch(&workers[w]->stats);
         }
 
-      ++progress;
+      // The statistics of the checkpoint go to the first thread.
+      workers[0]->stats += restored;
+
+      boost::thread_group tg;
+      for (int w = 0; w < nt; ++w)
+        tg.create_thread(boost::ref(*workers[w]));
+      tg.join_all();
+
+      // Merge the counts of the threads.
+      for (int w = 0; w < nt; ++w)
+        stats += workers[w]->stats;
     }
 
-  gsl_rng_free(rng);
+  // The last checkpoint tells that the replication is done.
+  if (cp.enabled())
+    cp.save(monitor.ended(), seed, pqv, stats, monitor, next_gen);
+
+  // The packets that are still on their way are gone with the pools.
+  for (int w = 0; w < workers.size(); ++w)
+    delete workers[w];
+
+  // Fill in the progress display for the time slots we didn't need.
+  progress += monitor.skipped();
+
+  return monitor.counted();
+}
+
+/**
+ * The replication of the simulation, that is run by function
+ * parallel_for.
+ */
+class replication_task
+{
+  const Graph &g;
+  const demand_table &dt;
+  int HL, DL;
+
+  /// The number of threads of a replication.
+  int threads;
+
+  /// The seed of the first replication.
+  unsigned long seed;
+
+  /// The precision and the time slot limit of a replication.
+  double precision;
+  timeslot max_slots;
+
+  /// True for the event mode.
+  bool events;
+
+  /// The prefix of the names of the checkpoint files, or empty for
+  /// none, and the number of time slots between checkpoints.
+  string checkpoint;
+  int checkpoint_slots;
+
+  /// True if the replications resume from their checkpoints.
+  bool resume;
+
+  checkpoint_writer &writer;
+
+  parallel_progress &progress;
+
+  /// Guards the merged counts.
+  boost::mutex m;
+
+public:
+  /// The merged statistics.
+  sim_stats stats;
+
+  /// The number of time slots of the merged statistics.
+  timeslot slots;
+
+  /// The link loads of the replications.
+  vector<map<Edge, double> > lls;
+
+  replication_task(const Graph &g, const demand_table &dt, int HL, int DL,
+                   int replications, int threads, unsigned long seed,
+                   double precision, timeslot max_slots, bool events,
+                   const string &checkpoint, int checkpoint_slots,
+                   bool resume, checkpoint_writer &writer,
+                   parallel_progress &progress) :
+    g(g), dt(dt), HL(HL), DL(DL), threads(threads), seed(seed),
+    precision(precision), max_slots(max_slots), events(events),
+    checkpoint(checkpoint), checkpoint_slots(checkpoint_slots),
+    resume(resume), writer(writer), progress(progress),
+    stats(g, HL, DL), slots(0), lls(replications)
+  {
+  }
+
+  void operator()(int r)
+  {
+    sim_stats rstats(g, HL, DL);
+
+    // Every replication has its own checkpoint file.
+    string name;
+    if (!checkpoint.empty())
+      {
+        ostringstream str;
+        str << checkpoint << "." << r;
+        name = str.str();
+      }
+
+    sim_checkpoint cp(g, HL, DL, precision, max_slots, events, name,
+                      checkpoint_slots, writer);
+
+    // Every replication has its own seed, and so its own streams of
+    // random numbers.
+    timeslot rslots = simulate(g, dt, HL, DL, threads, seed + r,
+                               precision, max_slots, events, cp, resume,
+                               rstats, progress);
+
+    // The link loads of this replication for the confidence intervals.
+    ptcm_matrix ptcmm;
+    pt_matrix ptm;
+    rstats.get_ptcmm(ptcmm);
+    ptcmm2ptm(ptcmm, ptm, rslots);
+    calculate_ll(ptm, lls[r], g);
+
+    boost::mutex::scoped_lock lock(m);
+    stats += rstats;
+    slots += rslots;
+  }
+};
+
+boost::tuple<pp_matrix, pt_matrix>
+sim_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
+             ostream &os)
+{
+  return sim_solution(g, tm, HL, DL, 1, 1, 0, 0, TS_LIMIT, false, "", 0,
+                      false, os);
+}
+
+boost::tuple<pp_matrix, pt_matrix>
+sim_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
+             int threads, unsigned long seed, ostream &os)
+{
+  return sim_solution(g, tm, HL, DL, 1, threads, seed, 0, TS_LIMIT,
+                      false, "", 0, false, os);
+}
+
+boost::tuple<pp_matrix, pt_matrix>
+sim_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
+             int replications, int threads, unsigned long seed,
+             double precision, int max_slots, bool events,
+             const string &checkpoint, int checkpoint_slots, bool resume,
+             ostream &os)
+{
+  assert(replications >= 1);
+  assert(threads >= 1);
+  assert(precision >= 0);
+  assert(max_slots >= 1);
+  assert(checkpoint.empty() || checkpoint_slots >= 1);
+
+  parallel_progress progress((unsigned long)replications * max_slots, os);
+
+  // The demands are compiled once for all replications.
+  demand_table dt(g, tm);
+
+  // The checkpoints of all replications are written by one thread in
+  // the background.  The writer outlives the replications, and so it
+  // writes their last checkpoints before we return.
+  checkpoint_writer writer;
+
+  // An event-mode replication runs on a single thread, and so there
+  // is no use for more threads than replications.
+  if (events)
+    threads = min(threads, replications);
+
+  // We run concurrently as many replications as we can, and give the
+  // remaining threads to the replications.
+  int rt = min(threads, replications);
+  replication_task task(g, dt, HL, DL, replications, threads / rt,
+                        seed, precision, max_slots, events, checkpoint,
+                        checkpoint_slots, resume, writer, progress);
+  parallel_for(replications, rt, task);
+
+  if (replications > 1)
+    {
+      map<Edge, pair<double, double> > ci;
+      calculate_ll_ci(task.lls, ci, CI_LEVEL);
+      print_ll_ci(ci, CI_LEVEL, g, os);
+    }
+
+  // The admissions of the demands over all replications.
+  adm_matrix am;
+  task.stats.get_admissions(am);
+  print_admissions(am, g, os);
 
   // Convert the simulation structures to structures that are
-  // returned.
+  // returned.  The distributions averaged over the replications,
+  // weighted with their lengths, are given by the counts of all
+  // replications.
+  ppcm_matrix ppcmm;
+  ptcm_matrix ptcmm;
+  task.stats.get_ppcmm(ppcmm);
+  task.stats.get_ptcmm(ptcmm);
+
   pp_matrix ppm;
   pt_matrix ptm;
-  ppcmm2ppm(ppcmm, ppm, TS_LIMIT);
-  ptcmm2ptm(ptcmm, ptm, TS_LIMIT);
+  ppcmm2ppm(ppcmm, ppm, task.slots);
+  ptcmm2ptm(ptcmm, ptm, task.slots);
 
   return tie(ppm, ptm);
 }
@@ -5,6 +5,7 @@
 #include "matrixes.hpp"
 
 #include <iostream>
+#include <string>
 
 /**
  * The simulative solver.
@@ -26,4 +27,105 @@ boost::tuple<pp_matrix, pt_matrix>
 sim_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
              ostream &os);
 
+/**
+ * The simulative solver that runs on many threads.  Every thread
+ * simulates its own set of nodes in a time slot, and the threads
+ * synchronize at the end of the time slot.  The random numbers of a
+ * node in a time slot come from a counter-based stream keyed by the
+ * seed, the node and the time slot, and so the results are the same
+ * for any number of threads.
+ *
+ * @param g the graph
+ *
+ * @param tm the traffic matrix
+ *
+ * @param HL the hop limit
+ *
+ * @param DL the distance limit
+ *
+ * @param threads the number of threads
+ *
+ * @param seed the seed of the random number streams
+ *
+ * @return a pair of the packet presence matrix and the packet
+ * trajectory matrix
+ *
+ * @see ana_solution
+ */
+boost::tuple<pp_matrix, pt_matrix>
+sim_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
+             int threads, unsigned long seed, ostream &os);
+
+/**
+ * The simulative solver that runs independent replications.  The
+ * replications run concurrently, and every replication has its own
+ * seed: the r-th replication is seeded with (seed + r).  The
+ * returned distributions are averaged over the replications.  For
+ * more than one replication, the confidence intervals of the link
+ * loads are printed to os.
+ *
+ * A replication runs max_slots time slots, unless the precision is
+ * given.  Then a replication stops earlier, when the batch means of
+ * the link loads and the packet loss probability converged with the
+ * given relative precision.  The time slots of the warm-up period
+ * are not counted then.
+ *
+ * In the event mode, a replication simulates a node only in the time
+ * slots in which it has packets to process: the time slots in which
+ * a node generates packets are drawn ahead with the geometric gaps
+ * between them, and a node that is sent a packet is scheduled for
+ * the time slot of its arrival.  The results are distributed the
+ * same as in the time-slot mode, but the cost depends on the number
+ * of packets, and not on the number of nodes times the number of
+ * time slots.  A replication runs then on a single thread, and so at
+ * most as many threads are used as there are replications.
+ *
+ * With the checkpoint given, replication r saves its state every
+ * checkpoint_slots time slots, and when it's done, to the file named
+ * checkpoint followed by ".r".  The checkpoints are written in the
+ * background.  When resuming, a replication continues from its
+ * checkpoint exactly as it would have without the break, since the
+ * random numbers are given by the seed, the node and the time slot.
+ * The seed is then taken from the checkpoint.
+ *
+ * @param g the graph
+ *
+ * @param tm the traffic matrix
+ *
+ * @param HL the hop limit
+ *
+ * @param DL the distance limit
+ *
+ * @param replications the number of replications
+ *
+ * @param threads the number of threads for all replications
+ *
+ * @param seed the seed of the first replication
+ *
+ * @param precision the relative precision, or 0 for none
+ *
+ * @param max_slots the largest number of time slots of a replication
+ *
+ * @param events true for the event mode
+ *
+ * @param checkpoint the prefix of the checkpoint file names, or empty
+ * for none
+ *
+ * @param checkpoint_slots the number of time slots between
+ * checkpoints
+ *
+ * @param resume true to resume from the checkpoints
+ *
+ * @return a pair of the packet presence matrix and the packet
+ * trajectory matrix
+ *
+ * @see ana_solution
+ */
+boost::tuple<pp_matrix, pt_matrix>
+sim_solution(const Graph &g, const fp_matrix &tm, int HL, int DL,
+             int replications, int threads, unsigned long seed,
+             double precision, int max_slots, bool events,
+             const string &checkpoint, int checkpoint_slots, bool resume,
+             ostream &os);
+
 #endif /* SIMULATION_HPP */
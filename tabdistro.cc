@@ -1,9 +1,10 @@
 #include "tabdistro.hpp"
 
-#include <boost/foreach.hpp>
+#include <gsl/gsl_fft_complex.h>
 
+#include <algorithm>
 #include <cassert>
-#include <iterator>
+#include <cfloat>
 #include <map>
 #include <set>
 #include <sstream>
@@ -16,8 +17,27 @@ BOOST_CLASS_EXPORT(tabdistro);
 
 using namespace std;
 
-tabdistro::tabdistro() {
-  probs.insert(prob_pair(1.0, 0));
+double tabdistro::epsilon = 0;
+
+tabdistro::tabdistro()
+{
+  clear();
+  add(prob_pair(1.0, 0));
+}
+
+tabdistro::tabdistro(const vector<double> &p)
+{
+  clear();
+
+  // The table has room for all values.
+  probs.reserve(p.size());
+  known.reserve(p.size());
+
+  for(int i = 1; i < p.size(); ++i)
+    if (p[i] != 0)
+      add(prob_pair(p[i], i));
+
+  sanitize();
 }
 
 tabdistro *
@@ -29,24 +49,33 @@ tabdistro::clone() const
 size_t
 tabdistro::size() const
 {
-  return probs.size();
+  return entries;
 }
 
 bool
 tabdistro::exists_ith_max(int i) const
 {
-  return i < probs.size();
+  return i < entries;
 }
 
 prob_pair
 tabdistro::get_ith_max(int i) const
 {
-  assert(i < probs.size());
+  assert(i < entries);
 
-  probs_cont::iterator ith_max = probs.begin();
-  advance(ith_max, i);
+  if (!sorted)
+    {
+      order.clear();
+      order.reserve(entries);
+      for(int v = 0; v < probs.size(); ++v)
+        if (known[v])
+          order.push_back(prob_pair(probs[v], v));
+
+      sort(order.begin(), order.end(), my_pair_order());
+      sorted = true;
+    }
 
-  return *ith_max;
+  return order[i];
 }
 
 double
@@ -54,26 +83,17 @@ tabdistro::get_prob(int i) const
 {
   assert(i >= 0);
 
-  // Iterate over all elements of the probs object
-  for(probs_cont::iterator ii = probs.begin(); ii != probs.end(); ++ii)
-    if (ii->second == i)
-      return ii->first;
-
-  return 0;
+  return i < probs.size() ? probs[i] : 0;
 }
 
 bool
 tabdistro::set_prob(const prob_pair &p)
 {
-  // Before we insert the pair, we need to see whether p.second
-  // already isn't stored.
-  BOOST_FOREACH(probs_cont::value_type i, probs)
-    if (p.second == i.second)
-      return false;
-
-  if (!probs.insert(p).second)
+  // We don't insert the pair if p.second is already stored.
+  if (p.second < known.size() && known[p.second])
     return false;
 
+  add(p);
   sanitize();
 
   return true;
@@ -84,18 +104,8 @@ tabdistro::to_tabular() const
 {
   ostringstream str;
 
-  map<int, double> val2prob;
-
-  int i_max = -1;
-
-  BOOST_FOREACH(probs_cont::value_type p, probs)
-    {
-      val2prob[p.second] = p.first;
-      i_max = max(i_max, p.second);
-    }
-
-  for(int i = 0; i <= i_max; ++i)
-    str << i << " " << val2prob[i] << endl;
+  for(int i = 0; i < probs.size(); ++i)
+    str << i << " " << probs[i] << endl;
 
   return str.str();
 }
@@ -109,34 +119,109 @@ tabdistro::output(ostream &out) const
 double
 tabdistro::mean() const
 {
-  double avg = 0;
+  return avg;
+}
 
-  BOOST_FOREACH(probs_cont::value_type p, probs)
-    avg += p.first * p.second;
+double
+tabdistro::get_epsilon()
+{
+  return epsilon;
+}
 
-  return avg;
+void
+tabdistro::set_epsilon(double e)
+{
+  epsilon = e;
 }
 
-tabdistro
-operator + (const tabdistro& d1, const tabdistro& d2)
+/**
+ * Convolves a and b directly into c.  The loops are plain, and the
+ * compiler vectorises the inner one.
+ */
+static void
+convolve_direct(const vector<double> &a, const vector<double> &b,
+                vector<double> &c)
 {
-  tabdistro ret;
+  for(int i = 0; i < a.size(); ++i)
+    {
+      double ai = a[i];
 
-  map<int, double> m;
+      if (ai != 0)
+        for(int j = 0; j < b.size(); ++j)
+          c[i + j] += ai * b[j];
+    }
+}
 
-  for(int i1 = 0; d1.exists_ith_max(i1); ++i1)
-    for(int i2 = 0; d2.exists_ith_max(i2); ++i2)
-      {
-        prob_pair p1 = d1.get_ith_max(i1);
-        prob_pair p2 = d2.get_ith_max(i2);
+/**
+ * Convolves a and b into c with the FFT.  The values that are at the
+ * level of the numerical noise of the FFT are zeroed.
+ */
+static void
+convolve_fft(const vector<double> &a, const vector<double> &b,
+             vector<double> &c)
+{
+  // The length of the FFT has to be a power of two.
+  size_t n = 1;
+  while(n < c.size())
+    n <<= 1;
+
+  // The complex numbers are packed: the real part, then the
+  // imaginary part.
+  vector<double> fa(2 * n), fb(2 * n);
+  for(int i = 0; i < a.size(); ++i)
+    fa[2 * i] = a[i];
+  for(int i = 0; i < b.size(); ++i)
+    fb[2 * i] = b[i];
+
+  gsl_fft_complex_radix2_forward(&fa[0], 1, n);
+  gsl_fft_complex_radix2_forward(&fb[0], 1, n);
+
+  for(int k = 0; k < n; ++k)
+    {
+      double re = fa[2 * k] * fb[2 * k] - fa[2 * k + 1] * fb[2 * k + 1];
+      double im = fa[2 * k] * fb[2 * k + 1] + fa[2 * k + 1] * fb[2 * k];
+      fa[2 * k] = re;
+      fa[2 * k + 1] = im;
+    }
 
-        m[p1.second + p2.second] += p1.first * p2.first;
-      }
+  gsl_fft_complex_radix2_inverse(&fa[0], 1, n);
+
+  double noise = n * DBL_EPSILON * TABDISTRO_FFT_NOISE;
+  for(int i = 0; i < c.size(); ++i)
+    c[i] = fa[2 * i] > noise ? fa[2 * i] : 0;
+}
 
-  for(map<int, double>::iterator mi = m.begin(); mi != m.end(); ++mi)
-    ret.set_prob(prob_pair(mi->second, mi->first));
+tabdistro
+operator + (const tabdistro& d1, const tabdistro& d2)
+{
+  const vector<double> &a = d1.probs;
+  const vector<double> &b = d2.probs;
+
+  if (a.empty() || b.empty())
+    return tabdistro();
+
+  // Element c[i] is the probability of value i of the sum.
+  vector<double> c(a.size() + b.size() - 1);
+
+  if (a.size() * b.size() <= TABDISTRO_FFT_THRESHOLD)
+    convolve_direct(a, b, c);
+  else
+    convolve_fft(a, b, c);
+
+  // Cut off the tail of the largest values whose probability is
+  // below epsilon.  The probability of the tail goes to the largest
+  // value kept, since the constructor would otherwise give it to
+  // value 0, and pull the mean down by up to the largest value times
+  // epsilon.
+  double tail = 0;
+  while(c.size() > 1 && tail + c.back() < tabdistro::epsilon)
+    {
+      tail += c.back();
+      c.pop_back();
+    }
+  c.back() += tail;
 
-  return ret;
+  return tabdistro(c);
 }
 
 tabdistro &
@@ -150,7 +235,26 @@ operator += (tabdistro &d1, const tabdistro &d2)
 bool
 tabdistro::operator == (const tabdistro &d) const
 {
-  return probs == d.probs;
+  if (entries != d.entries)
+    return false;
+
+  // Compare the entries of the values that both tables have.
+  size_t n = min(probs.size(), d.probs.size());
+  for(int i = 0; i < n; ++i)
+    if (known[i] != d.known[i] || (known[i] && probs[i] != d.probs[i]))
+      return false;
+
+  // The values that only one of the tables has can't have entries,
+  // because the numbers of entries are equal.
+  for(int i = n; i < probs.size(); ++i)
+    if (known[i])
+      return false;
+
+  for(int i = n; i < d.probs.size(); ++i)
+    if (d.known[i])
+      return false;
+
+  return true;
 }
 
 bool
@@ -160,25 +264,56 @@ tabdistro::operator != (const tabdistro &d) const
 }
 
 void
-tabdistro::sanitize() const
+tabdistro::clear()
+{
+  probs.clear();
+  known.clear();
+  entries = 0;
+  sum = 0;
+  avg = 0;
+  order.clear();
+  sorted = false;
+}
+
+void
+tabdistro::add(const prob_pair &p)
 {
-  // Find the entry for the zero.
-  probs_cont::iterator i = probs.begin();
-  while(i != probs.end() && i->second != 0)
-    ++i;
+  int i = p.second;
+  assert(i >= 0);
+
+  if (i >= probs.size())
+    {
+      probs.resize(i + 1);
+      known.resize(i + 1);
+    }
 
-  // Remove the entry for the zero if it was found.
-  if (i != probs.end())
-    probs.erase(i);
+  assert(!known[i]);
+  probs[i] = p.first;
+  known[i] = true;
+  ++entries;
 
-  double sum = 0;
-  BOOST_FOREACH(probs_cont::value_type p, probs)
+  if (i)
     sum += p.first;
+  avg += p.first * i;
+  sorted = false;
+}
+
+void
+tabdistro::sanitize()
+{
+  // Remove the entry for the zero if there is one.
+  if (!known.empty() && known[0])
+    {
+      probs[0] = 0;
+      known[0] = false;
+      --entries;
+      sorted = false;
+    }
 
   assert(sum <= 1.01);
 
   // The probability of getting zero.
   double prob = 1 - sum;
   if (prob != 0.0)
-    probs.insert(prob_pair(prob, 0));
+    add(prob_pair(prob, 0));
 }
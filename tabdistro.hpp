@@ -7,36 +7,61 @@
 #include <functional>
 #include <iostream>
 #include <set>
+#include <vector>
 
 #include <boost/serialization/access.hpp>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/set.hpp>
+#include <boost/serialization/split_member.hpp>
 #include <boost/serialization/utility.hpp>
 
+/**
+ * The distributions are added with the FFT, when the product of the
+ * numbers of their values is larger than this threshold.  Otherwise
+ * they are added directly.
+ */
+#define TABDISTRO_FFT_THRESHOLD 4096
+
+/**
+ * The values from the FFT that are not larger than this factor times
+ * the length of the FFT times the machine epsilon are taken as zero.
+ */
+#define TABDISTRO_FFT_NOISE 16
+
 using namespace std;
 
 /**
  * This distribution is given by the user.  It's the tabular
  * distribution, i.e. it's given by a table.
+ *
+ * The probabilities are kept in a table indexed with the values of
+ * the random variable, and so getting the probability of a value is
+ * constant-time.  The values sorted by decreasing probability, which
+ * get_ith_max needs, are figured out when needed, and remembered
+ * until the distribution changes.
  */
 
 class tabdistro : public distro_base, private counter<tabdistro>
 {
   friend class boost::serialization::access;
 
-  template<class Archive>
-  void serialize(Archive &ar, const unsigned int version)
-  {
-    boost::serialization::base_object<distro_base>(*this);
-    ar & probs;
-  }
+  friend tabdistro
+  operator + (const tabdistro &d1, const tabdistro &d2);
+
+  /**
+   * When distributions are added, the largest values of the sum are
+   * cut off as long as their total probability is below epsilon.
+   * Their probability goes to the largest value kept, and so the
+   * smaller values are untouched.
+   */
+  static double epsilon;
 
   // This is our sorting functor for prob_pair.
   class my_pair_order : binary_function<const prob_pair &,
                                         const prob_pair &, bool>
   {
   public:
-    bool operator()(const prob_pair &p1, const prob_pair &p2)
+    bool operator()(const prob_pair &p1, const prob_pair &p2) const
     {
       if (p1.first == p2.first)
         return p1.second < p2.second;
@@ -45,13 +70,80 @@ class tabdistro : public distro_base, private counter<tabdistro>
     }
   };
 
+  /**
+   * This is the type of the container in which the distribution was
+   * kept, and in which it's serialized.
+   */
   typedef set<prob_pair, my_pair_order> probs_cont;
 
-  mutable probs_cont probs;
+  /**
+   * Element probs[i] is the probability of value i.
+   */
+  vector<double> probs;
+
+  /**
+   * Element known[i] tells whether there is an entry for value i.
+   */
+  vector<char> known;
+
+  /**
+   * The number of entries.
+   */
+  size_t entries;
+
+  /**
+   * The sum of the probabilities of the values other than zero.
+   */
+  double sum;
+
+  /**
+   * The mean of the distribution.
+   */
+  double avg;
+
+  /**
+   * The entries sorted by decreasing probability.  It's valid when
+   * sorted is true.
+   */
+  mutable vector<prob_pair> order;
+
+  mutable bool sorted;
+
+  template<class Archive>
+  void save(Archive &ar, const unsigned int version) const
+  {
+    boost::serialization::base_object<distro_base>(*this);
+    probs_cont pc;
+    for(int i = 0; i < probs.size(); ++i)
+      if (known[i])
+        pc.insert(prob_pair(probs[i], i));
+    ar & pc;
+  }
+
+  template<class Archive>
+  void load(Archive &ar, const unsigned int version)
+  {
+    boost::serialization::base_object<distro_base>(*this);
+    probs_cont pc;
+    ar & pc;
+    clear();
+    for(probs_cont::iterator i = pc.begin(); i != pc.end(); ++i)
+      add(*i);
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
 
 public:
   tabdistro();
 
+  /**
+   * Builds the distribution in one go.  Element probs[i] is the
+   * probability of value i, and there is an entry for every value
+   * other than zero whose probability is not zero.  Element probs[0]
+   * is ignored, because the probability of zero is what's left.
+   */
+  tabdistro(const vector<double> &probs);
+
   tabdistro *clone() const;
 
   /**
@@ -84,14 +176,34 @@ public:
 
   double mean() const;
 
+  /**
+   * Returns the value of epsilon.
+   */
+  static double get_epsilon();
+
+  /**
+   * Sets the value of epsilon, which is 0 by default.
+   */
+  static void set_epsilon(double epsilon);
+
   using counter<tabdistro>::how_many;
 
 private:
+  /**
+   * Removes all entries.
+   */
+  void clear();
+
+  /**
+   * Adds the entry for a value that has no entry yet.
+   */
+  void add(const prob_pair &p);
+
   /**
    * This function is called by the set_prob function to make sure
    * that there's also an entry when the random variable is zero.
    */
-  void sanitize() const;
+  void sanitize();
 };
 
 /**
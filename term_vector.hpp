@@ -0,0 +1,123 @@
+#ifndef TERM_VECTOR_HPP
+#define TERM_VECTOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * The terms of a polynomial kept contiguously in a vector, sorted by
+ * the power.  It has the interface of map<size_t, T> that the
+ * polynomials need, but it's much cheaper to copy and to iterate
+ * over, because the terms of a polynomial are few and the powers are
+ * small.
+ *
+ * Only the terms that were asked for are kept, just like with a map,
+ * and so a term can have a zero coefficient.
+ */
+template<typename T>
+class term_vector
+{
+public:
+  typedef size_t key_type;
+  typedef T mapped_type;
+  typedef pair<size_t, T> value_type;
+  typedef vector<value_type> container_type;
+  typedef typename container_type::size_type size_type;
+  typedef typename container_type::iterator iterator;
+  typedef typename container_type::const_iterator const_iterator;
+  typedef typename container_type::reverse_iterator reverse_iterator;
+  typedef typename container_type::const_reverse_iterator
+  const_reverse_iterator;
+
+private:
+  /// The terms sorted by the power.
+  container_type terms;
+
+  /// Compares the power of a term with a power.
+  static bool power_less(const value_type &t, size_t i)
+  {
+    return t.first < i;
+  }
+
+public:
+  iterator begin() { return terms.begin(); }
+  iterator end() { return terms.end(); }
+  const_iterator begin() const { return terms.begin(); }
+  const_iterator end() const { return terms.end(); }
+
+  reverse_iterator rbegin() { return terms.rbegin(); }
+  reverse_iterator rend() { return terms.rend(); }
+  const_reverse_iterator rbegin() const { return terms.rbegin(); }
+  const_reverse_iterator rend() const { return terms.rend(); }
+
+  size_type size() const { return terms.size(); }
+  bool empty() const { return terms.empty(); }
+  void clear() { terms.clear(); }
+  void reserve(size_type n) { terms.reserve(n); }
+
+  void swap(term_vector &tv)
+  {
+    terms.swap(tv.terms);
+  }
+
+  /**
+   * Returns the coefficient of the i-th power, and creates the term
+   * if it doesn't exist.  Appending the terms in the order of powers
+   * is the cheapest.
+   */
+  T &operator[](size_t i)
+  {
+    if (terms.empty() || terms.back().first < i)
+      {
+        terms.push_back(value_type(i, T()));
+        return terms.back().second;
+      }
+
+    iterator it = lower_bound(terms.begin(), terms.end(), i, power_less);
+
+    if (it->first != i)
+      it = terms.insert(it, value_type(i, T()));
+
+    return it->second;
+  }
+
+  /**
+   * Appends the term of the i-th power, which has to be larger than
+   * the powers of the terms already there.
+   */
+  void push_back(size_t i, const T &c_i)
+  {
+    assert(terms.empty() || terms.back().first < i);
+    terms.push_back(value_type(i, c_i));
+  }
+
+  iterator find(size_t i)
+  {
+    iterator it = lower_bound(terms.begin(), terms.end(), i, power_less);
+    return it != terms.end() && it->first == i ? it : terms.end();
+  }
+
+  const_iterator find(size_t i) const
+  {
+    const_iterator it = lower_bound(terms.begin(), terms.end(), i,
+                                    power_less);
+    return it != terms.end() && it->first == i ? it : terms.end();
+  }
+
+  size_type count(size_t i) const
+  {
+    return find(i) != end();
+  }
+
+  bool operator == (const term_vector &tv) const
+  {
+    return terms == tv.terms;
+  }
+};
+
+#endif /* TERM_VECTOR_HPP */
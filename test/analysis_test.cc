@@ -0,0 +1,215 @@
+#include "analysis.hpp"
+#include "arguments.hpp"
+#include "graph.hpp"
+#include "polynomial.hpp"
+#include "serializer.hpp"
+#include "test.hpp"
+#include "utils.hpp"
+
+#include <cstdlib>
+#include <list>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// This tests the incremental iterations of the analytical solver.
+
+using namespace std;
+
+/**
+ * Creates the line graph 0 - 1 - 2 - 3.
+ */
+void
+make_graph(Graph &g)
+{
+  g = Graph(4);
+
+  for(int i = 0; i < 3; ++i)
+    {
+      Edge e = add_edge(i, i + 1, g).first;
+      put(edge_weight, g, e, 1);
+      put(edge_weight2, g, e, 2);
+    }
+
+  complete_graph(g);
+}
+
+/**
+ * Puts into the trajectories of every destination of the ptm a
+ * marker: the trajectory of source 99, which is not in the graph.
+ */
+void
+mark(pt_matrix &ptm)
+{
+  for(pt_matrix::iterator i = ptm.begin(); i != ptm.end(); ++i)
+    i->second[99];
+}
+
+/**
+ * Tells whether destination i of the ptm has the marker.
+ */
+bool
+marked(const pt_matrix &ptm, Vertex i)
+{
+  pt_matrix::const_iterator r = ptm.find(i);
+  return r != ptm.end() && r->second.count(99);
+}
+
+/**
+ * Returns the number of lines of the output with the given prefix.
+ */
+int
+count_lines(const string &out, const string &prefix)
+{
+  istringstream in(out);
+  string line;
+  int n = 0;
+
+  while(getline(in, line))
+    if (!line.compare(0, prefix.size(), prefix))
+      ++n;
+
+  return n;
+}
+
+/**
+ * Returns the values after the prefix on the lines with the prefix.
+ */
+vector<double>
+values(const string &out, const string &prefix)
+{
+  istringstream in(out);
+  string line;
+  vector<double> v;
+
+  while(getline(in, line))
+    if (!line.compare(0, prefix.size(), prefix))
+      v.push_back(atof(line.c_str() + prefix.size()));
+
+  return v;
+}
+
+int
+main()
+{
+  int HL = 5;
+  int DL = 10;
+  double tolerance = 1e-6;
+
+  Graph g;
+  make_graph(g);
+
+  fp_matrix tm;
+  tm[3][0] = 0.5;
+  tm[0][3] = 0.25;
+  tm[2][1] = 0.125;
+
+  dist_poly::set_S(DL + 1);
+
+  // The incremental iterations.
+  {
+    stringstream devnull;
+    vector<route_cache> caches(num_vertices(g));
+
+    // The rates of the first iteration, in which no packets are in
+    // the network yet.
+    list<ana_rates> rates_list(1);
+    generate_rates(g, tm, pt_matrix(), 1, rates_list.back());
+
+    // There's nothing to reuse in the first iteration.
+    ana_history history;
+    ana_iteration(g, HL, 1, rates_list, caches, tolerance, history,
+                  devnull);
+    pt_matrix ptm = history.ptm;
+    EXPECT(ptm.size(), 3);
+    TEST(!history.atm.empty());
+    TEST(!history.epm.empty());
+
+    // The first iteration is the same as the one that's not
+    // incremental.
+    {
+      pp_matrix ppm2;
+      pt_matrix ptm2;
+      tie(ppm2, ptm2) = ana_iteration(g, HL, 1, rates_list, caches,
+                                      devnull);
+      TEST(ptm2 == ptm);
+    }
+
+    // With the same rates nothing changed, and so the rows of all the
+    // destinations are taken from the history, as the markers show.
+    {
+      mark(history.ptm);
+
+      ostringstream os;
+      ana_iteration(g, HL, 1, rates_list, caches, tolerance, history, os);
+      EXPECT(count_lines(os.str(), "Tracing 0 of 4 destinations"), 1);
+
+      TEST(marked(history.ptm, 0));
+      TEST(marked(history.ptm, 2));
+      TEST(marked(history.ptm, 3));
+    }
+
+    // A destination whose admission rate changed is traced again, and
+    // so it loses the marker, and gets the right trajectories.  So
+    // does a destination whose edge probabilities changed.  The other
+    // destination keeps the marker.
+    {
+      history.atm[3][0] += 10 * tolerance;
+      history.epm.erase(2);
+
+      ostringstream os;
+      ana_iteration(g, HL, 1, rates_list, caches, tolerance, history, os);
+      EXPECT(count_lines(os.str(), "Tracing 2 of 4 destinations"), 1);
+
+      TEST(marked(history.ptm, 0));
+      TEST(!marked(history.ptm, 2));
+      TEST(!marked(history.ptm, 3));
+      TEST(history.ptm[2] == ptm[2]);
+      TEST(history.ptm[3] == ptm[3]);
+    }
+
+    // A change below the tolerance is ignored, and the rate of the
+    // history is kept.
+    {
+      double rate = history.atm[3][0];
+      history.atm[3][0] += tolerance / 10;
+
+      ostringstream os;
+      ana_iteration(g, HL, 1, rates_list, caches, tolerance, history, os);
+      EXPECT(count_lines(os.str(), "Tracing 0 of 4 destinations"), 1);
+      EXPECT(history.atm[3][0], rate + tolerance / 10);
+    }
+  }
+
+  // The solver stops when the link-load residual falls below the
+  // tolerance, and not before.
+  {
+    int iters = 100;
+    double tolerance = 1e-4;
+
+    arguments args;
+    serializer s(args, g, tm);
+    ostringstream os;
+    ana_solution(g, tm, HL, DL, iters, 1, 1, tolerance, os, s);
+
+    string out = os.str();
+    int n = count_lines(out, "Iteration #");
+    TEST(n > 1 && n < iters);
+
+    // There's a residual for every iteration but the first, and
+    // only the last one is below the tolerance.
+    vector<double> r = values(out, "Link-load residual: ");
+    EXPECT(r.size(), n - 1);
+    TEST(r.back() < tolerance);
+    for(int i = 0; i < r.size() - 1; ++i)
+      TEST(r[i] >= tolerance);
+
+    // Without the tolerance all the iterations are made.
+    ostringstream os2;
+    ana_solution(g, tm, HL, DL, n + 2, 1, 1, 0, os2, s);
+    EXPECT(count_lines(os2.str(), "Iteration #"), n + 2);
+    EXPECT(count_lines(os2.str(), "Link-load residual: "), 0);
+  }
+
+  return 0;
+}
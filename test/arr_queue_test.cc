@@ -2,8 +2,11 @@
 #include "distro.hpp"
 #include "nodistro.hpp"
 #include "poisson.hpp"
+#include "tabdistro.hpp"
 #include "test.hpp"
 
+#include <cmath>
+#include <set>
 #include <vector>
 
 using namespace std;
@@ -55,5 +58,40 @@ main()
     EXPECT(arr[1], 0);
   }
 
+  // The test for all arrangements of two tabdistro groups.  Every
+  // arrangement has to be returned once, even though most of them can
+  // be reached from two other arrangements.
+  {
+    tabdistro t1;
+    t1.set_prob(make_pair(0.2, 1));
+    t1.set_prob(make_pair(0.3, 2));
+    tabdistro t2;
+    t2.set_prob(make_pair(0.4, 1));
+    t2.set_prob(make_pair(0.1, 3));
+
+    vector<distro> distros;
+    distros.push_back(distro(t1));
+    distros.push_back(distro(t2));
+
+    arr_queue q(distros);
+    q.set_ratio(0);
+
+    vector<int> arr;
+    double prob, last = 1, sum = 0;
+    set<vector<int> > arrs;
+
+    while(q.find_next(arr, prob))
+      {
+        TEST(prob <= last);
+        TEST(arrs.insert(arr).second);
+        last = prob;
+        sum += prob;
+      }
+
+    EXPECT(arrs.size(), 9);
+    EXPECT(q.get_size(), 0);
+    TEST(fabs(sum - 1) < 1e-12);
+  }
+
   return 0;
 }
@@ -0,0 +1,73 @@
+#include "batch_means.hpp"
+#include "graph.hpp"
+#include "sim_stats.hpp"
+#include "test.hpp"
+
+using namespace std;
+
+/**
+ * Makes the counts of a batch of 100 time slots, in which the link
+ * from node 0 to node 1 carried n packets, and packets were lost with
+ * the probability of 0.1.
+ */
+batch_counts
+make_batch(int n)
+{
+  batch_counts bc;
+  bc.transits.resize(4);
+  bc.transits[0 * 2 + 1] = n;
+  bc.offered = 100;
+  bc.delivered = 90;
+
+  return bc;
+}
+
+int
+main()
+{
+  Graph g(2);
+  Edge e = add_edge(0, 1, g).first;
+  put(edge_weight2, g, e, 1);
+
+  // The warm-up is over when the load levels off.
+  {
+    batch_means bm(g, 0.1, 100, 0.95);
+
+    EXPECT(bm.add(make_batch(10)), false);
+    EXPECT(bm.warmed_up(), false);
+    EXPECT(bm.add(make_batch(50)), false);
+    EXPECT(bm.add(make_batch(52)), true);
+    EXPECT(bm.warmed_up(), true);
+    EXPECT(bm.converged(), false);
+  }
+
+  // The simulation converges with steady batch means, but not
+  // earlier than after a number of batches.
+  {
+    batch_means bm(g, 0.1, 100, 0.95);
+
+    bm.add(make_batch(50));
+    bm.add(make_batch(50));
+
+    for(int i = 0; i < 9; ++i)
+      bm.add(make_batch(49 + i % 3));
+    EXPECT(bm.converged(), false);
+
+    bm.add(make_batch(50));
+    EXPECT(bm.converged(), true);
+  }
+
+  // The simulation doesn't converge with scattered batch means.
+  {
+    batch_means bm(g, 0.01, 100, 0.95);
+
+    bm.add(make_batch(50));
+    bm.add(make_batch(50));
+
+    for(int i = 0; i < 20; ++i)
+      bm.add(make_batch(i % 2 ? 20 : 80));
+    EXPECT(bm.converged(), false);
+  }
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include "calendar_queue.hpp"
+#include "packet.hpp"
+#include "test.hpp"
+
+using namespace std;
+
+
+int
+main()
+{
+  // The empty queue.
+  {
+    calendar_queue q(3);
+    EXPECT(q.size(), 0);
+
+    slot_pkts pkts;
+    q.pop(0, pkts);
+    EXPECT(pkts.size(), 0);
+  }
+
+  // Packets are popped in their time slots only.
+  {
+    calendar_queue q(3);
+
+    // The source is 0, the destination is 1.
+    packet p1(0, 1, 10);
+    packet p2(0, 1, 11);
+    packet p3(0, 1, 12);
+
+    q.insert(&p3);
+    q.insert(&p1);
+    q.insert(&p2);
+    EXPECT(q.size(), 3);
+
+    slot_pkts pkts;
+    q.pop(10, pkts);
+    EXPECT(pkts.size(), 1);
+    EXPECT(pkts[0], &p1);
+    EXPECT(q.size(), 2);
+
+    // The popped packets are appended.
+    q.pop(11, pkts);
+    EXPECT(pkts.size(), 2);
+    EXPECT(pkts[1], &p2);
+
+    pkts.clear();
+    q.pop(12, pkts);
+    EXPECT(pkts.size(), 1);
+    EXPECT(pkts[0], &p3);
+
+    // The bucket of time slot 12 is reused by time slot 15.
+    packet p4(0, 1, 15);
+    q.insert(&p4);
+
+    pkts.clear();
+    q.pop(15, pkts);
+    EXPECT(pkts.size(), 1);
+    EXPECT(pkts[0], &p4);
+    EXPECT(q.size(), 0);
+  }
+
+  // Packets of the same time slot keep the order of insertion.
+  {
+    calendar_queue q(2);
+
+    packet p1(0, 1, 10);
+    packet p2(0, 2, 10);
+    packet p3(0, 3, 10);
+
+    q.insert(&p2);
+    q.insert(&p3);
+    q.insert(&p1);
+
+    slot_pkts pkts;
+    q.pop(10, pkts);
+    EXPECT(pkts.size(), 3);
+    EXPECT(pkts[0], &p2);
+    EXPECT(pkts[1], &p3);
+    EXPECT(pkts[2], &p1);
+  }
+
+  // The packets in the queue are listed without removing them, and
+  // inserting them again gives the same queue.
+  {
+    calendar_queue q(3);
+
+    packet p1(0, 1, 10);
+    packet p2(0, 2, 11);
+    packet p3(0, 3, 10);
+
+    q.insert(&p1);
+    q.insert(&p2);
+    q.insert(&p3);
+
+    slot_pkts pkts;
+    q.packets(pkts);
+    EXPECT(pkts.size(), 3);
+    EXPECT(q.size(), 3);
+
+    calendar_queue q2(3);
+    for(slot_pkts::iterator i = pkts.begin(); i != pkts.end(); ++i)
+      q2.insert(*i);
+
+    pkts.clear();
+    q2.pop(10, pkts);
+    EXPECT(pkts.size(), 2);
+    EXPECT(pkts[0], &p1);
+    EXPECT(pkts[1], &p3);
+  }
+
+  return 0;
+}
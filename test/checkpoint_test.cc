@@ -0,0 +1,60 @@
+#include "checkpoint.hpp"
+#include "test.hpp"
+
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+int
+main()
+{
+  // The names of the temporary checkpoints.
+  const char *name1 = "checkpoint_test.1";
+  const char *name2 = "checkpoint_test.2";
+
+  // The data with the null characters is written as is.
+  {
+    string data("a\0b", 3);
+    TEST(write_checkpoint(name1, data));
+
+    string data2;
+    TEST(read_checkpoint(name1, data2));
+    TEST(data2 == data);
+  }
+
+  // The writer takes over the data, and writes the last checkpoint
+  // of every file.
+  {
+    {
+      checkpoint_writer writer;
+
+      string data = "first";
+      writer.write(name1, data);
+      TEST(data.empty());
+
+      data = "second";
+      writer.write(name1, data);
+
+      data = "other";
+      writer.write(name2, data);
+    }
+
+    string data;
+    TEST(read_checkpoint(name1, data));
+    TEST(data == "second");
+    TEST(read_checkpoint(name2, data));
+    TEST(data == "other");
+  }
+
+  // A file that doesn't exist.
+  {
+    remove(name1);
+    remove(name2);
+
+    string data;
+    TEST(!read_checkpoint(name1, data));
+  }
+
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include "csr_matrix.hpp"
+#include "sparse_matrix.hpp"
+#include "test.hpp"
+
+using namespace std;
+
+
+int
+main()
+{
+  // An empty matrix.
+  {
+    csr_matrix<int, int> m;
+    EXPECT(m.rows(), 0);
+    EXPECT(m.size(), 0);
+    TEST(m.empty());
+    TEST(!m.exists(0, 0));
+  }
+
+  // A frozen matrix has the elements of the sparse matrix.
+  {
+    sparse_matrix<int, int> sm;
+    sm[5][1] = 51;
+    sm[1][3] = 13;
+    sm[1][0] = 10;
+    sm[3][3] = 33;
+    // This row is empty, and it's not kept.
+    sm[4];
+
+    csr_matrix<int, int> m(sm);
+    EXPECT(m.rows(), 3);
+    EXPECT(m.size(), 4);
+
+    EXPECT(m.at(1, 0), 10);
+    EXPECT(m.at(1, 3), 13);
+    EXPECT(m.at(3, 3), 33);
+    EXPECT(m.at(5, 1), 51);
+
+    TEST(!m.exists(0, 0));
+    TEST(!m.exists(1, 1));
+    TEST(!m.exists(4, 0));
+    TEST(!m.exists(6, 1));
+  }
+
+  // The rows and the elements of the rows are iterated in order.
+  {
+    sparse_matrix<int, int> sm;
+    sm[2][7] = 27;
+    sm[2][1] = 21;
+    sm[0][4] = 4;
+
+    csr_matrix<int, int> m(sm);
+    EXPECT(m.key(0), 0);
+    EXPECT(m.key(1), 2);
+
+    csr_matrix<int, int>::const_iterator i = m.begin(0);
+    EXPECT(i->first, 4); EXPECT(i->second, 4); ++i;
+    TEST(i == m.end(0));
+
+    i = m.begin(1);
+    EXPECT(i->first, 1); EXPECT(i->second, 21); ++i;
+    EXPECT(i->first, 7); EXPECT(i->second, 27); ++i;
+    TEST(i == m.end(1));
+  }
+
+  return 0;
+}
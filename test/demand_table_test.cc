@@ -0,0 +1,107 @@
+#include "demand_table.hpp"
+#include "graph.hpp"
+#include "matrixes.hpp"
+#include "packet_pool.hpp"
+#include "test.hpp"
+#include "utils_sim.hpp"
+
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+int
+main()
+{
+  Graph g(4);
+
+  // Node 0 sends to nodes 1 and 2, and node 1 sends to node 3 only.
+  fp_matrix tm;
+  tm[1][0] = 0.5;
+  tm[2][0] = 1.5;
+  tm[3][1] = 1;
+
+  demand_table dt(g, tm);
+  EXPECT(dt.rate(0), 2);
+  EXPECT(dt.rate(1), 1);
+  EXPECT(dt.rate(2), 0);
+  EXPECT(dt.rate(3), 0);
+
+  packet_pool pool;
+
+  // The numbers of packets per destination.
+  vector<int> count(4);
+  int slots = 100000;
+
+  for(int ts = 0; ts < slots; ++ts)
+    {
+      slot_pkts pkts;
+      stream_rng rng(1, 0, ts, stream_rng::GENERATION);
+      dt.generate(0, ts, pkts, rng, pool);
+      dt.generate(1, ts, pkts, rng, pool);
+
+      // Nodes without demands generate nothing.
+      dt.generate(2, ts, pkts, rng, pool);
+      dt.generate(3, ts, pkts, rng, pool);
+
+      for(slot_pkts::iterator i = pkts.begin(); i != pkts.end(); ++i)
+        {
+          TEST((*i)->start_ts == ts);
+          TEST((*i)->src == 0 && ((*i)->dst == 1 || (*i)->dst == 2) ||
+               (*i)->src == 1 && (*i)->dst == 3);
+          ++count[(*i)->dst];
+        }
+
+      release_pkts(pkts, pool);
+    }
+
+  // The rates of the demands.
+  EXPECT(count[0], 0);
+  TEST(fabs(double(count[1]) / slots - 0.5) < 0.01);
+  TEST(fabs(double(count[2]) / slots - 1.5) < 0.02);
+  TEST(fabs(double(count[3]) / slots - 1) < 0.02);
+
+  // The same rates when only the time slots with packets are visited.
+  count.assign(4, 0);
+
+  for(Vertex j = 0; j < 4; ++j)
+    {
+      stream_rng rng(1, j, 0, stream_rng::GAP);
+      timeslot ts = dt.next_active(j, 0, rng);
+
+      // Nodes without demands never generate.
+      if (dt.rate(j) == 0)
+        {
+          EXPECT(ts, demand_table::never);
+          continue;
+        }
+
+      while(ts < slots)
+        {
+          slot_pkts pkts;
+          stream_rng gen_rng(1, j, ts, stream_rng::GENERATION);
+          dt.generate_active(j, ts, pkts, gen_rng, pool);
+          TEST(!pkts.empty());
+
+          for(slot_pkts::iterator i = pkts.begin(); i != pkts.end(); ++i)
+            {
+              TEST((*i)->start_ts == ts && (*i)->src == j);
+              ++count[(*i)->dst];
+            }
+
+          release_pkts(pkts, pool);
+
+          stream_rng gap_rng(1, j, ts + 1, stream_rng::GAP);
+          timeslot next = dt.next_active(j, ts + 1, gap_rng);
+          TEST(next > ts);
+          ts = next;
+        }
+    }
+
+  EXPECT(count[0], 0);
+  TEST(fabs(double(count[1]) / slots - 0.5) < 0.01);
+  TEST(fabs(double(count[2]) / slots - 1.5) < 0.02);
+  TEST(fabs(double(count[3]) / slots - 1) < 0.02);
+
+  return 0;
+}
@@ -25,5 +25,39 @@ main()
     EXPECT(d.is_nodistro(), true);
   }
 
+  {
+    // Test the copying and the assignment of distros of all kinds.
+    distro d1 = poisson(1.5);
+    distro d2 = tabdistro();
+    distro d3 = d1;
+    TEST(d3 == d1);
+    EXPECT(d3.mean(), 1.5);
+    d3 = d2;
+    EXPECT(d3.is_tabdistro(), true);
+    TEST(d3 == d2);
+    TEST(!(d3 == d1));
+    d3 = d3;
+    EXPECT(d3.is_tabdistro(), true);
+  }
+  EXPECT(distro::how_many(), 0);
+  EXPECT(distro_base::how_many(), 0);
+
+  {
+    // Test the operators.
+    distro d1 = poisson(1.5);
+    d1 += distro(poisson(2.5));
+    TEST(d1 == distro(poisson(4.0)));
+    d1 *= 0.5;
+    TEST(d1 == distro(poisson(2.0)));
+    d1 += distro();
+    TEST(d1 == distro(poisson(2.0)));
+
+    distro d2;
+    d2 += d1;
+    TEST(d2 == d1);
+  }
+  EXPECT(distro::how_many(), 0);
+  EXPECT(poisson::how_many(), 0);
+
   return 0;
 }
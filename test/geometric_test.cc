@@ -14,6 +14,7 @@ main()
     geometric dist(p);
     EXPECT(geometric::how_many(), 1);
 
+    EXPECT(dist.get_prob(0), 0);
     EXPECT(dist.get_prob(1), gsl_ran_geometric_pdf(1, p));
     EXPECT(dist.get_prob(10), gsl_ran_geometric_pdf(10, p));
   }
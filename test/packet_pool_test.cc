@@ -0,0 +1,163 @@
+#include "packet_pool.hpp"
+#include "test.hpp"
+
+#include <set>
+#include <vector>
+
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace std;
+
+/**
+ * The packets that the sender passes to the receiver, by the parity
+ * of the time slot.
+ */
+typedef vector<slot_pkts> pass_buffers;
+
+/**
+ * A thread of the test.  Thread 0 only allocates packets, and passes
+ * them to thread 1, which only releases them.
+ */
+class pool_user
+{
+  int w;
+  int slots;
+  int n;
+  pass_buffers &pass;
+  pool_balancer &pb;
+  boost::barrier &bar;
+
+public:
+  packet_pool pool;
+
+  pool_user(int w, int slots, int n, pass_buffers &pass,
+            pool_balancer &pb, boost::barrier &bar) :
+    w(w), slots(slots), n(n), pass(pass), pb(pb), bar(bar)
+  {
+  }
+
+  void operator()()
+  {
+    for(timeslot ts = 0; ts < slots; ++ts)
+      {
+        pb.take(w, ts, pool);
+
+        if (!w)
+          for(int i = 0; i < n; ++i)
+            pass[ts % 2].push_back(pool.alloc(0, 1, ts));
+        else if (ts)
+          {
+            for(slot_pkts::iterator i = pass[(ts - 1) % 2].begin();
+                i != pass[(ts - 1) % 2].end(); ++i)
+              pool.release(*i);
+            pass[(ts - 1) % 2].clear();
+          }
+
+        pb.give(w, ts, pool);
+        bar.wait();
+      }
+  }
+};
+
+
+int
+main()
+{
+  // A packet is constructed with the given arguments.
+  {
+    packet_pool pool;
+
+    packet *pkt = pool.alloc(1, 2, 10);
+    EXPECT(pkt->src, 1);
+    EXPECT(pkt->dst, 2);
+    EXPECT(pkt->start_ts, 10);
+    EXPECT(pkt->next_ts, 10);
+    EXPECT(pkt->hops, 0);
+
+    pool.release(pkt);
+  }
+
+  // A released packet is reused.
+  {
+    packet_pool pool;
+
+    packet *p1 = pool.alloc(1, 2, 10);
+    pool.release(p1);
+
+    packet *p2 = pool.alloc(3, 4, 20);
+    EXPECT(p1, p2);
+    EXPECT(p2->src, 3);
+    EXPECT(p2->next_ts, 20);
+  }
+
+  // Many packets are distinct, even from many chunks.
+  {
+    packet_pool pool;
+    set<packet *> pkts;
+
+    for(int i = 0; i < 5000; ++i)
+      pkts.insert(pool.alloc(0, 1, i));
+
+    EXPECT(pkts.size(), 5000);
+  }
+
+  // A packet can be released to another pool.
+  {
+    packet_pool pool1;
+    packet_pool pool2;
+
+    packet *p1 = pool1.alloc(1, 2, 10);
+    pool2.release(p1);
+
+    EXPECT(pool2.alloc(3, 4, 20), p1);
+  }
+
+  // The free packets of one pool are taken by the other.
+  {
+    pool_balancer pb(2);
+    packet_pool pool1;
+    packet_pool pool2;
+
+    // Two chunks in the first pool, and so one chunk is spare.
+    slot_pkts pkts;
+    for(int i = 0; i < 2048; ++i)
+      pkts.push_back(pool1.alloc(0, 1, 0));
+    for(int i = 0; i < pkts.size(); ++i)
+      pool1.release(pkts[i]);
+    EXPECT(pool1.chunk_count(), 2);
+
+    pb.give(0, 0, pool1);
+    pb.take(1, 1, pool2);
+
+    // The second pool allocates only from the spare packets.
+    for(int i = 0; i < 1024; ++i)
+      pool2.alloc(0, 1, 0);
+    EXPECT(pool2.chunk_count(), 0);
+  }
+
+  // When one thread only sends packets and the other only receives
+  // them, the pools allocate only about as many chunks as there are
+  // packets on their way, not as many as there were sent.
+  {
+    // The number of time slots, and of the packets sent in a slot.
+    int slots = 1000;
+    int n = 500;
+
+    pass_buffers pass(2);
+    pool_balancer pb(2);
+    boost::barrier bar(2);
+
+    pool_user sender(0, slots, n, pass, pb, bar);
+    pool_user receiver(1, slots, n, pass, pb, bar);
+
+    boost::thread t(boost::ref(receiver));
+    sender();
+    t.join();
+
+    // Without the balancer the sender would take 500 chunks.
+    TEST(sender.pool.chunk_count() + receiver.pool.chunk_count() <= 4);
+  }
+
+  return 0;
+}
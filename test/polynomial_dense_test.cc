@@ -0,0 +1,4 @@
+// The test of the polynomials that keep their terms in term_vectors.
+
+#define DENSE_POLY
+#include "polynomial_test.cc"
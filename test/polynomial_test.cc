@@ -4,8 +4,32 @@
 #include "test.hpp"
 #include "utils.hpp"
 
+#include <map>
+#include <sstream>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/serialization/map.hpp>
+
 // This tests the tpoly class.  We operate here on the polynomials
 // with integer coefficients, so that it's easier to test the class.
+// The test is also built with DENSE_POLY defined.
+
+/**
+ * Loads what was saved as a polynomial into a map, to check that
+ * the polynomials are saved as maps, however the terms are kept.
+ */
+template<typename T>
+struct map_poly
+{
+  map<size_t, T> m;
+
+  template<class Archive>
+  void serialize(Archive &ar, const unsigned int version)
+  {
+    ar & m;
+  }
+};
 
 int
 main()
@@ -89,6 +113,26 @@ main()
     EXPECT(p3, result);
   }
 
+  // Test the multiplication of fp_poly with gaps and truncation.
+  {
+    fp_poly::set_S(7);
+
+    fp_poly p1;
+    fp_poly p2;
+
+    p1(1.0, 0)(3.0, 1)(0.0, 4);
+    p2(2.0, 0)(0.5, 2)(1.0, 6);
+
+    fp_poly p3 = p1 * p2;
+    fp_poly result;
+
+    // The term 0*x^4 exists, and the terms of the power 7 and higher
+    // are discarded.
+    result(2.0, 0)(6.0, 1)(0.5, 2)(1.5, 3)(0.0, 4)(1.0, 6);
+
+    EXPECT(p3, result);
+  }
+
   // Test the sum function
   {
     fp_poly p;
@@ -180,5 +224,56 @@ main()
   }
   EXPECT(poisson::how_many(), 0);
 
+  // The polynomials are saved as maps, and loaded back.
+  {
+    tpoly<double> p;
+    p[1] = 0.5;
+    p[3] = 0.25;
+
+    dist_poly dp;
+    dp[0] = distro(poisson(1.0));
+    dp[2] = distro(poisson(2.0));
+    dp[4] = distro(poisson(3.0));
+
+    stringstream s;
+    {
+      const tpoly<double> &cp = p;
+      const dist_poly &cdp = dp;
+      boost::archive::text_oarchive oa(s);
+      oa << cp << cdp;
+    }
+
+    string str = s.str();
+
+    {
+      map_poly<double> m;
+      map_poly<distro> dm;
+      istringstream in(str);
+      boost::archive::text_iarchive ia(in);
+      ia >> m >> dm;
+
+      EXPECT(m.m.size(), 2);
+      EXPECT(m.m[1], 0.5);
+      EXPECT(m.m[3], 0.25);
+
+      EXPECT(dm.m.size(), 3);
+      TEST(dm.m[0] == dp[0]);
+      TEST(dm.m[2] == dp[2]);
+      TEST(dm.m[4] == dp[4]);
+    }
+
+    {
+      tpoly<double> p2;
+      dist_poly dp2;
+      istringstream in(str);
+      boost::archive::text_iarchive ia(in);
+      ia >> p2 >> dp2;
+
+      TEST(p2 == p);
+      TEST(dp2 == dp);
+    }
+  }
+  EXPECT(poisson::how_many(), 0);
+
   return 0;
 }
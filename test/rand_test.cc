@@ -0,0 +1,106 @@
+#include "rand.hpp"
+#include "test.hpp"
+
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+int
+main()
+{
+  // The known answer of Philox4x32-10 for the zero key and counter.
+  {
+    stream_rng r(0, 0, 0, stream_rng::GENERATION);
+    EXPECT(r.get(), 0x6627e8d5);
+    EXPECT(r.get(), 0xe169c58d);
+    EXPECT(r.get(), 0xbc57ac4c);
+    EXPECT(r.get(), 0x9b00dbd8);
+  }
+
+  // A stream is given by its key and counter only.
+  {
+    stream_rng r1(5, 3, 100, stream_rng::ADMISSION);
+    stream_rng r2(5, 3, 100, stream_rng::ADMISSION);
+    stream_rng r3(5, 3, 100, stream_rng::GENERATION);
+    stream_rng r4(5, 4, 100, stream_rng::ADMISSION);
+    stream_rng r5(5, 3, 101, stream_rng::ADMISSION);
+
+    bool d3 = false, d4 = false, d5 = false;
+    for(int i = 0; i < 10; ++i)
+      {
+        boost::uint32_t x = r1.get();
+        EXPECT(r2.get(), x);
+        d3 |= r3.get() != x;
+        d4 |= r4.get() != x;
+        d5 |= r5.get() != x;
+      }
+
+    TEST(d3 && d4 && d5);
+  }
+
+  // The numbers drawn in bulk are the same as drawn one by one.
+  {
+    stream_rng r1(1, 2, 3, stream_rng::GENERATION);
+    stream_rng r2(1, 2, 3, stream_rng::GENERATION);
+
+    vector<double> u(11);
+    r1.uniform();
+    r1.uniform(&u[0], u.size());
+
+    r2.uniform();
+    for(int i = 0; i < u.size(); ++i)
+      {
+        EXPECT(r2.uniform(), u[i]);
+        TEST(u[i] >= 0 && u[i] < 1);
+      }
+  }
+
+  // The uniform integers are in range, and about equally likely.
+  {
+    stream_rng r(1, 1, 1, stream_rng::ADMISSION);
+    vector<int> count(3);
+    int n = 300000;
+
+    for(int i = 0; i < n; ++i)
+      {
+        boost::uint32_t k = r.uniform_int(3);
+        TEST(k < 3);
+        ++count[k];
+      }
+
+    for(int k = 0; k < 3; ++k)
+      TEST(fabs(double(count[k]) / n - 1.0 / 3) < 0.005);
+
+    EXPECT(r.uniform_int(1), 0);
+  }
+
+  // The mean and the variance of the Poisson distribution, both for
+  // the inversion and the rejection.
+  {
+    double mus[] = {0, 0.3, 2, 9.5, 10, 25, 300};
+
+    for(int m = 0; m < sizeof(mus) / sizeof(mus[0]); ++m)
+      {
+        double mu = mus[m];
+        double s = 0, s2 = 0;
+        int n = 100000;
+
+        for(int t = 0; t < n; ++t)
+          {
+            stream_rng r(7, 3, t, stream_rng::GENERATION);
+            int k = r.poisson(mu);
+            TEST(k >= 0);
+            s += k;
+            s2 += double(k) * k;
+          }
+
+        double mean = s / n;
+        double var = s2 / n - mean * mean;
+        TEST(fabs(mean - mu) <= 0.02 * mu + 0.01);
+        TEST(fabs(var - mu) <= 0.05 * mu + 0.01);
+      }
+  }
+
+  return 0;
+}
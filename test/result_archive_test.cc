@@ -0,0 +1,177 @@
+#include "analysis.hpp"
+#include "arguments.hpp"
+#include "distro.hpp"
+#include "graph.hpp"
+#include "graph_serialization.hpp"
+#include "poisson.hpp"
+#include "result_archive.hpp"
+#include "tabdistro.hpp"
+#include "test.hpp"
+#include "utils.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+int
+main()
+{
+  // The name of the temporary archive.
+  const char *name = "result_archive_test.bin";
+
+  // A small ptm with the kinds of distributions that trajectories
+  // have: the geometric distribution is only for admissions, and it
+  // can't be summed up into the link loads.
+  {
+    arguments args;
+    args.HL = 1;
+    args.DL = 10;
+    args.iters = 1;
+    args.method = analysis;
+    args.touch_random_seed = false;
+    args.AL = 1;
+
+    Graph g(3);
+    Edge e1 = add_edge(0, 1, g).first;
+    Edge e2 = add_edge(1, 2, g).first;
+    put(edge_weight2, g, e1, 2);
+    put(edge_weight2, g, e2, 4);
+
+    fp_matrix tm;
+    tm[2][0] = 1;
+
+    tabdistro td;
+    td.set_prob(prob_pair(0.75, 3));
+
+    dist_poly dp1;
+    dp1[1] = distro(poisson(0.5));
+    dp1[2] = distro(poisson(0.25));
+
+    dist_poly dp2;
+    dp2[3] = distro(td);
+    dp2[4] = distro();
+
+    pt_matrix ptm;
+    ptm[2][0][1][e1] = dp1;
+    ptm[2][0][2][e2] = dp2;
+
+    TEST(save_result_archive(name, args, g, tm, ptm));
+
+    result_archive archive;
+    TEST(archive.open(name));
+
+    arguments args2;
+    Graph g2;
+    fp_matrix tm2;
+    archive.load_meta(args2, g2, tm2);
+    EXPECT(args2.HL, 1);
+    EXPECT(args2.DL, 10);
+    TEST(test_graphs(g, g2));
+    TEST(tm == tm2);
+
+    // The link loads are the same as calculated from the ptm.
+    map<Edge, double> ll, ll2;
+    calculate_ll(ptm, ll, g);
+    archive.load_ll(g2, ll2);
+    EXPECT(ll.size(), 2);
+    EXPECT(ll2.size(), 2);
+    EXPECT(ll2[edge(0, 1, g2).first], ll[e1]);
+    EXPECT(ll2[edge(1, 2, g2).first], ll[e2]);
+
+    // The rates of the demand.
+    EXPECT(archive.demands(), 1);
+    EXPECT(archive.demand(0).dst, 2);
+    EXPECT(archive.demand(0).src, 0);
+    EXPECT(archive.demand(0).in_rate, 1);
+    EXPECT(archive.demand(0).out_rate, sum(dp2).mean());
+
+    // The whole ptm.  We load it for the first graph, so that the
+    // edges are the same.
+    pt_matrix ptm2;
+    archive.load_ptm(g, ptm2);
+    TEST(ptm == ptm2);
+  }
+
+  // The links used in both directions keep their own loads and
+  // trajectories.
+  {
+    arguments args;
+    args.HL = 2;
+    args.DL = 10;
+    args.iters = 1;
+    args.method = analysis;
+    args.touch_random_seed = false;
+    args.AL = 2;
+
+    Graph g(3);
+    add_edge(0, 1, g);
+    add_edge(1, 2, g);
+    BGL_FORALL_EDGES(e, g, Graph)
+      put(edge_weight2, g, e, 1);
+
+    // The forward links, and the reverse links.
+    Edge e01 = edge(0, 1, g).first;
+    Edge e12 = edge(1, 2, g).first;
+    Edge e10 = edge(1, 0, g).first;
+    Edge e21 = edge(2, 1, g).first;
+
+    fp_matrix tm;
+    tm[2][0] = 0.5;
+    tm[0][2] = 0.25;
+
+    dist_poly dp1;
+    dp1[1] = distro(poisson(0.5));
+
+    dist_poly dp2;
+    dp2[1] = distro(poisson(0.25));
+
+    pt_matrix ptm;
+    ptm[2][0][1][e01] = dp1;
+    ptm[2][0][2][e12] = dp1;
+    ptm[0][2][1][e21] = dp2;
+    ptm[0][2][2][e10] = dp2;
+
+    TEST(save_result_archive(name, args, g, tm, ptm));
+
+    result_archive archive;
+    TEST(archive.open(name));
+
+    map<Edge, double> ll, ll2;
+    calculate_ll(ptm, ll, g);
+    archive.load_ll(g, ll2);
+    EXPECT(ll.size(), 4);
+    TEST(ll2 == ll);
+    EXPECT(ll2[e01], 0.5);
+    EXPECT(ll2[e10], 0.25);
+    EXPECT(ll2[e12], 0.5);
+    EXPECT(ll2[e21], 0.25);
+
+    pt_matrix ptm2;
+    archive.load_ptm(g, ptm2);
+    TEST(ptm == ptm2);
+    EXPECT(ptm2[0][2][1].begin()->first, e21);
+    EXPECT(ptm2[0][2][2].begin()->first, e10);
+  }
+
+  // A text archive is not a binary result archive.
+  {
+    {
+      ofstream out(name);
+      out << "22 serialization::archive" << endl;
+    }
+
+    result_archive archive;
+    TEST(!archive.open(name));
+  }
+
+  // A file that doesn't exist.
+  {
+    remove(name);
+    result_archive archive;
+    TEST(!archive.open(name));
+  }
+
+  return 0;
+}
@@ -0,0 +1,176 @@
+#include "arguments.hpp"
+#include "graph.hpp"
+#include "graph_serialization.hpp"
+#include "matrixes.hpp"
+#include "poisson.hpp"
+#include "result_archive.hpp"
+#include "result_reader.hpp"
+#include "test.hpp"
+#include "utils.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/serialization/string.hpp>
+
+using namespace std;
+
+/**
+ * Records what is read.
+ */
+class test_subscriber: public result_subscriber
+{
+  bool wants;
+
+public:
+  map<Edge, double> ll;
+  fp_matrix out_rates;
+  pt_matrix ptm;
+
+  test_subscriber(bool wants) : wants(wants)
+  {
+  }
+
+  bool
+  wants_trajectories() const
+  {
+    return wants;
+  }
+
+  void
+  link_load(Edge e, double load)
+  {
+    ll[e] = load;
+  }
+
+  void
+  demand_rate(Vertex dst, Vertex src, double in_rate, double out_rate)
+  {
+    out_rates[dst][src] = out_rate;
+  }
+
+  void
+  trajectory(Vertex dst, Vertex src, const packet_trajectory &pt)
+  {
+    ptm[dst][src] = pt;
+  }
+};
+
+/**
+ * Reads the archive, and checks the results against the ptm.
+ */
+void
+check(const char *name, const Graph &g, const pt_matrix &ptm)
+{
+  for(int w = 0; w < 2; ++w)
+    {
+      arguments args;
+      Graph g2;
+      fp_matrix tm;
+      test_subscriber s(w);
+      TEST(read_results(name, args, g2, tm, s));
+      TEST(test_graphs(g, g2));
+      EXPECT(args.HL, 1);
+
+      EXPECT(s.ll.size(), 2);
+      EXPECT(s.ll[edge(0, 1, g2).first], 1);
+      EXPECT(s.ll[edge(1, 2, g2).first], 0.5);
+
+      TEST(s.out_rates.exists(2, 0));
+      EXPECT(s.out_rates.at(2, 0), 0.5);
+
+      // The trajectories are passed only when they are wanted.
+      EXPECT(s.ptm.size(), w);
+      if (w)
+        EXPECT(s.ptm[2][0].size(), ptm.at(2, 0).size());
+    }
+}
+
+/**
+ * Saves the text archive.
+ */
+void
+save_text(const char *name, const arguments &args, const Graph &g,
+          const fp_matrix &tm, const pt_matrix &ptm)
+{
+  ofstream out(name);
+  boost::archive::text_oarchive oa(out);
+  oa.get_helper<graph_helper>().g = &g;
+  oa << args;
+  oa << g;
+  oa << tm;
+  oa << ptm;
+}
+
+int
+main()
+{
+  const char *name = "result_reader_test.out";
+
+  arguments args;
+  args.HL = 1;
+
+  Graph g(3);
+  Edge e1 = add_edge(0, 1, g).first;
+  Edge e2 = add_edge(1, 2, g).first;
+  put(edge_weight2, g, e1, 1);
+  put(edge_weight2, g, e2, 1);
+
+  fp_matrix tm;
+  tm[2][0] = 1;
+
+  // Half of the packets are lost at node 1.
+  pt_matrix ptm;
+  ptm[2][0][1][e1][1] = distro(poisson(1));
+  ptm[2][0][2][e2][2] = distro(poisson(0.5));
+
+  // The binary result archive.
+  TEST(save_result_archive(name, args, g, tm, ptm));
+  check(name, g, ptm);
+
+  // The text archive.
+  save_text(name, args, g, tm, ptm);
+  check(name, g, ptm);
+
+  // The links used in both directions are read the same from both
+  // archives.
+  {
+    fp_matrix tm2 = tm;
+    tm2[0][2] = 1;
+
+    pt_matrix ptm2 = ptm;
+    ptm2[0][2][1][edge(2, 1, g).first][1] = distro(poisson(0.75));
+    ptm2[0][2][2][edge(1, 0, g).first][2] = distro(poisson(0.25));
+
+    test_subscriber sb(true), st(true);
+    Graph gb, gt;
+    fp_matrix tmb, tmt;
+
+    TEST(save_result_archive(name, args, g, tm2, ptm2));
+    TEST(read_results(name, args, gb, tmb, sb));
+
+    save_text(name, args, g, tm2, ptm2);
+    TEST(read_results(name, args, gt, tmt, st));
+
+    EXPECT(sb.ll.size(), 4);
+    TEST(sb.ll == st.ll);
+    EXPECT(sb.ll[edge(2, 1, gb).first], 0.75);
+    EXPECT(sb.ll[edge(1, 0, gb).first], 0.25);
+
+    TEST(sb.ptm == st.ptm);
+    TEST(sb.out_rates == st.out_rates);
+  }
+
+  // A file that doesn't exist.
+  remove(name);
+  {
+    Graph g2;
+    fp_matrix tm2;
+    test_subscriber s(false);
+    TEST(!read_results(name, args, g2, tm2, s));
+  }
+
+  return 0;
+}
@@ -0,0 +1,67 @@
+#include "route_cache.hpp"
+#include "test.hpp"
+
+#include <map>
+
+using namespace std;
+
+
+int
+main()
+{
+  // The key lists the destinations and the numbers of packets.
+  {
+    map<Vertex, int> arr;
+    arr[3] = 1;
+    arr[1] = 2;
+
+    route_cache::key_type k = route_cache::encode(arr);
+    EXPECT(k.size(), 4);
+    EXPECT(k[0], 1);
+    EXPECT(k[1], 2);
+    EXPECT(k[2], 3);
+    EXPECT(k[3], 1);
+  }
+
+  // The lookups are counted.
+  {
+    route_cache c;
+    route_cache::key_type k(2, 1);
+
+    EXPECT(c.hit_rate(), 0.0);
+    TEST(!c.find(k));
+
+    edge_count_map count;
+    count[1];
+    c.insert(k, count);
+    EXPECT(c.size(), 1);
+
+    const edge_count_map *r = c.find(k);
+    TEST(r);
+    EXPECT(r->size(), 1);
+    TEST(r->count(1));
+
+    EXPECT(c.hits(), 1);
+    EXPECT(c.misses(), 1);
+    EXPECT(c.hit_rate(), 0.5);
+  }
+
+  // The least recently used result is evicted.
+  {
+    route_cache c(2);
+    route_cache::key_type k1(1, 1), k2(1, 2), k3(1, 3);
+
+    c.insert(k1, edge_count_map());
+    c.insert(k2, edge_count_map());
+    // Now k2 is the least recently used.
+    TEST(c.find(k1));
+    c.insert(k3, edge_count_map());
+
+    EXPECT(c.size(), 2);
+    TEST(c.find(k1));
+    TEST(!c.find(k2));
+    TEST(c.find(k3));
+  }
+
+  return 0;
+}
@@ -67,12 +67,13 @@ main()
     pt_matrix ptm;
     ptm[0][1] = pt;
 
-    p_graph = &g;
     boost::archive::text_oarchive oa(s);
+    oa.get_helper<graph_helper>().g = &g;
     oa << ptm;
 
     pt_matrix ptm2;
     boost::archive::text_iarchive ia(s);
+    ia.get_helper<graph_helper>().g = &g;
     ia >> ptm2;
 
     TEST(ptm == ptm2);
@@ -105,20 +106,20 @@ main()
     stringstream devnull;
     tie(ppm, ptm1) = ana_solution(g1, tm, HL, DL, 5, 5, devnull);
 
-    // Here we set the pointer to the graph that should be used for
-    // writing the objects.
+    // Here we set the graph that should be used for writing the
+    // objects.
     boost::archive::text_oarchive oa(s);
     oa << g1;
-    p_graph = &g1;
+    oa.get_helper<graph_helper>().g = &g1;
     oa << ptm1;
 
     Graph g2;
     pt_matrix ptm2;
-    // Here we set the pointer to the graph that should be used for
-    // reading the objects.
+    // Here we set the graph that should be used for reading the
+    // objects.
     boost::archive::text_iarchive ia(s);
     ia >> g2;
-    p_graph = &g2;
+    ia.get_helper<graph_helper>().g = &g2;
     ia >> ptm2;
 
     TEST(test_graphs(g1, g2));
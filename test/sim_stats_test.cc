@@ -0,0 +1,177 @@
+#include "graph.hpp"
+#include "matrixes.hpp"
+#include "packet.hpp"
+#include "sim_stats.hpp"
+#include "test.hpp"
+
+#include <sstream>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+using namespace std;
+
+
+int
+main()
+{
+  Graph g(3);
+  Edge e = add_edge(0, 1, g).first;
+
+  // The presence of packets is counted per time slot.
+  {
+    sim_stats s(g, 5, 10);
+
+    // The source is 0, the destination is 2.
+    packet p1(0, 2, 10);
+    packet p2(0, 2, 10);
+
+    // Two packets in the first time slot.
+    s.report_presence(0, p1);
+    s.report_presence(0, p2);
+    s.close_slot();
+
+    // One packet in the second time slot.
+    s.report_presence(0, p1);
+    s.close_slot();
+
+    // Another two packets.
+    s.report_presence(0, p1);
+    s.report_presence(0, p2);
+    s.close_slot();
+
+    ppcm_matrix ppcmm;
+    s.get_ppcmm(ppcmm);
+
+    // The packets made no hops, and incurred no delay.
+    count_map_poly &cmp = ppcmm[2][0][0][0];
+    EXPECT(cmp.size(), 1);
+    EXPECT(cmp[0].size(), 2);
+    EXPECT(cmp[0][1], 1);
+    EXPECT(cmp[0][2], 2);
+  }
+
+  // The transition of packets, and the merging of statistics.
+  {
+    sim_stats s1(g, 5, 10);
+    sim_stats s2(g, 5, 10);
+
+    packet p1(0, 2, 10);
+    p1.hops = 1;
+    p1.next_ts = 13;
+
+    s1.report_transition(e, p1);
+    s1.close_slot();
+    s2.report_transition(e, p1);
+    s2.close_slot();
+
+    s1 += s2;
+
+    ptcm_matrix ptcmm;
+    s1.get_ptcmm(ptcmm);
+
+    EXPECT(ptcmm[2][0][1].size(), 1);
+    EXPECT(ptcmm[2][0][1].begin()->first, e);
+    EXPECT(ptcmm[2][0][1][e][3][1], 2);
+  }
+
+  // The packet presence and trajectory are kept apart.
+  {
+    sim_stats s(g, 5, 10);
+
+    packet p1(0, 1, 10);
+    s.report_presence(0, p1);
+    s.report_transition(e, p1);
+    s.close_slot();
+
+    ppcm_matrix ppcmm;
+    s.get_ppcmm(ppcmm);
+    EXPECT(ppcmm[1][0][0][0][0][1], 1);
+
+    ptcm_matrix ptcmm;
+    s.get_ptcmm(ptcmm);
+    EXPECT(ptcmm[1][0][0][e][0][1], 1);
+  }
+
+  // The admissions are counted per demand, merged, and discarded
+  // with the warm-up period.
+  {
+    sim_stats s1(g, 5, 10);
+    sim_stats s2(g, 5, 10);
+
+    packet p1(0, 2, 10);
+    packet p2(1, 2, 10);
+    s1.report_admitted(p1);
+    s1.report_rejected(p1);
+    s2.report_admitted(p1);
+    s2.report_rejected(p2);
+
+    s1 += s2;
+
+    adm_matrix am;
+    s1.get_admissions(am);
+    EXPECT(am.size(), 1);
+    EXPECT(am[2].size(), 2);
+    EXPECT(am[2][0].first, 2);
+    EXPECT(am[2][0].second, 1);
+    EXPECT(am[2][1].first, 0);
+    EXPECT(am[2][1].second, 1);
+
+    s1.clear();
+    adm_matrix am2;
+    s1.get_admissions(am2);
+    TEST(am2.empty());
+  }
+
+  // The statistics are saved and loaded with the counts of the
+  // current batch, which are also merged.
+  {
+    sim_stats s1(g, 5, 10);
+    sim_stats s2(g, 5, 10);
+
+    packet p1(0, 2, 10);
+    p1.hops = 1;
+    p1.next_ts = 13;
+
+    s1.report_presence(0, p1);
+    s1.report_transition(e, p1);
+    s1.report_offered(3);
+    s1.report_admitted(p1);
+    s1.close_slot();
+
+    ostringstream out;
+    {
+      boost::archive::binary_oarchive oa(out);
+      oa << s1;
+    }
+
+    istringstream in(out.str());
+    {
+      boost::archive::binary_iarchive ia(in);
+      ia >> s2;
+    }
+
+    ppcm_matrix ppcmm1, ppcmm2;
+    s1.get_ppcmm(ppcmm1);
+    s2.get_ppcmm(ppcmm2);
+    TEST(ppcmm1 == ppcmm2);
+
+    ptcm_matrix ptcmm1, ptcmm2;
+    s1.get_ptcmm(ptcmm1);
+    s2.get_ptcmm(ptcmm2);
+    TEST(ptcmm1 == ptcmm2);
+
+    adm_matrix am;
+    s2.get_admissions(am);
+    EXPECT(am[2][0].first, 1);
+
+    s2 += s1;
+
+    batch_counts bc;
+    s2.take_batch(bc);
+    EXPECT(bc.offered, 6);
+    EXPECT(bc.transits[0 * 3 + 1], 2);
+  }
+
+  return 0;
+}
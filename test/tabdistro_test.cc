@@ -2,8 +2,10 @@
 #include "tabdistro.hpp"
 #include "test.hpp"
 
+#include <cmath>
 #include <sstream>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -235,6 +237,104 @@ main()
     }
   }
 
+  // Test building a tabdistro in one go.
+  {
+    vector<double> probs(9);
+    probs[4] = 0.25;
+    probs[8] = 0.75;
+    tabdistro t(probs);
+
+    EXPECT(t, d);
+    EXPECT(t.size(), 2);
+    EXPECT(t.get_prob(0), 0.0);
+    EXPECT(t.get_ith_max(1).second, 4);
+    EXPECT(t.mean(), 7.0);
+  }
+
+  // The probability of zero is what's left.
+  {
+    vector<double> probs(3);
+    probs[0] = 0.5;
+    probs[2] = 0.5;
+    tabdistro t(probs);
+
+    EXPECT(t.size(), 2);
+    EXPECT(t.get_prob(0), 0.5);
+    EXPECT(t.get_ith_max(0).second, 0);
+    EXPECT(t.get_ith_max(1).second, 2);
+  }
+
+  // Test the addition of large distributions, which uses the FFT.
+  {
+    vector<double> p1(101), p2(101);
+    for(int i = 1; i <= 100; ++i)
+      p1[i] = p2[i] = 0.01;
+    tabdistro t1(p1), t2(p2);
+
+    tabdistro s = t1 + t2;
+    TEST(fabs(s.mean() - 101) < 1e-9);
+    TEST(fabs(s.get_prob(101) - 0.01) < 1e-12);
+    TEST(fabs(s.get_prob(2) - 0.0001) < 1e-12);
+    TEST(fabs(s.get_prob(200) - 0.0001) < 1e-12);
+    EXPECT(s.get_prob(201), 0.0);
+    EXPECT(s.get_prob(1), 0.0);
+    // The sum gets zero only because of the rounding errors.
+    TEST(s.get_prob(0) < 1e-12);
+  }
+
+  // Test the cut-off of the tail.
+  {
+    tabdistro t;
+    t.set_prob(make_pair(0.5, 1));
+
+    tabdistro::set_epsilon(0.3);
+    tabdistro s = t + t;
+    tabdistro::set_epsilon(0);
+
+    // Value 2 had the probability of 0.25, and it went to value 1.
+    // Value 0 keeps its probability.
+    EXPECT(s.size(), 2);
+    EXPECT(s.get_prob(2), 0.0);
+    EXPECT(s.get_prob(1), 0.75);
+    EXPECT(s.get_prob(0), 0.25);
+    EXPECT(s.mean(), 0.75);
+  }
+
+  // The cut-off of a long tail moves its probability to the largest
+  // value kept.
+  {
+    // The probabilities of values 0 to 50, with a thin tail above 10.
+    vector<double> p(51);
+    for(int i = 0; i <= 10; ++i)
+      p[i] = 0.09;
+    for(int i = 11; i <= 50; ++i)
+      p[i] = 0.01 / 40;
+    tabdistro t(p);
+
+    tabdistro exact = t + t;
+
+    tabdistro::set_epsilon(0.001);
+    tabdistro s = t + t;
+    tabdistro::set_epsilon(0);
+
+    // Some of the tail was cut off, but the probability of value 0 is
+    // the same.
+    TEST(s.get_prob(100) == 0 && exact.get_prob(100) > 0);
+    TEST(fabs(s.get_prob(0) - exact.get_prob(0)) < 1e-15);
+
+    // The largest value kept.
+    int last = 100;
+    while(s.get_prob(last) == 0)
+      --last;
+
+    // The mean went down only by moving the tail to the largest value
+    // kept.
+    double drop = 0;
+    for(int v = last + 1; v <= 100; ++v)
+      drop += (v - last) * exact.get_prob(v);
+    TEST(drop > 0);
+    TEST(fabs(exact.mean() - s.mean() - drop) < 1e-9);
+  }
 
   return 0;
 }
@@ -0,0 +1,5 @@
+// The test of the term_vector built along with the polynomials that
+// keep their terms in term_vectors.
+
+#define DENSE_POLY
+#include "term_vector_test.cc"
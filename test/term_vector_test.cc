@@ -0,0 +1,72 @@
+#include "term_vector.hpp"
+#include "test.hpp"
+
+using namespace std;
+
+
+int
+main()
+{
+  // The terms are kept in the order of the powers, no matter in
+  // which order they were created.
+  {
+    term_vector<int> tv;
+    tv[5] = 5;
+    tv[1] = 1;
+    tv[3] = 3;
+    tv[7] = 7;
+
+    EXPECT(tv.size(), 4);
+
+    term_vector<int>::const_iterator i = tv.begin();
+    EXPECT(i->first, 1); EXPECT(i->second, 1); ++i;
+    EXPECT(i->first, 3); EXPECT(i->second, 3); ++i;
+    EXPECT(i->first, 5); EXPECT(i->second, 5); ++i;
+    EXPECT(i->first, 7); EXPECT(i->second, 7); ++i;
+    TEST(i == tv.end());
+  }
+
+  // A term is created once, and then it's reused.
+  {
+    term_vector<int> tv;
+    tv[2] += 1;
+    tv[2] += 1;
+    tv[0] += 1;
+    tv[0] += 1;
+
+    EXPECT(tv.size(), 2);
+    EXPECT(tv[0], 2);
+    EXPECT(tv[2], 2);
+  }
+
+  // Find and count.
+  {
+    term_vector<int> tv;
+    tv.push_back(1, 10);
+    tv.push_back(4, 40);
+
+    TEST(tv.find(0) == tv.end());
+    TEST(tv.find(2) == tv.end());
+    TEST(tv.find(5) == tv.end());
+    EXPECT(tv.find(4)->second, 40);
+    EXPECT(tv.count(1), 1);
+    EXPECT(tv.count(3), 0);
+  }
+
+  // Comparison and swapping.
+  {
+    term_vector<int> a, b;
+    a[3] = 1;
+    a[0] = 2;
+    b.push_back(0, 2);
+    b.push_back(3, 1);
+    TEST(a == b);
+
+    term_vector<int> c;
+    c.swap(a);
+    TEST(a.empty());
+    TEST(c == b);
+  }
+
+  return 0;
+}
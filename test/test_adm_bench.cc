@@ -0,0 +1,126 @@
+#include "analysis.hpp"
+#include "graph.hpp"
+#include "poisson.hpp"
+#include "simulation.hpp"
+#include "utils.hpp"
+#include "utils_ana.hpp"
+#include "utils_sim.hpp"
+
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <string>
+
+using namespace std;
+
+// This compares the exact admission ratio calculated with the CDFs
+// with the one calculated with the arrangements, and with the
+// simulation, for the networks in ../runs.  We also report the time
+// the two analytical calculations take.
+
+/**
+ * The number of times we calculate the ratios to measure the time.
+ */
+#define REPEAT 100
+
+static int
+bench(const string &name, int HL, int DL)
+{
+  string dot_name = "../runs/" + name + ".dot";
+  string tm_name = "../runs/" + name + ".tm";
+
+  // Here we create the graph.
+  Graph g;
+  if (!read_graphviz_filename(dot_name.c_str(), g))
+    {
+      cerr << "Error loading the graphviz file.\n";
+      return 1;
+    }
+
+  map<string, Vertex> vn = get_vertex_names(g);
+
+  // Here we create the traffic matrix.
+  fp_matrix tm;
+  if (!load_tm_file(tm_name.c_str(), vn, tm))
+    {
+      cerr << "Error loading the traffic matrix file.\n";
+      return 1;
+    }
+
+  pp_matrix sim_ppm;
+  pt_matrix sim_ptm;
+
+  cerr << "\tRunning simulation of " << name << "... ";
+  tie(sim_ppm, sim_ptm) = sim_solution(g, tm, HL, DL, cerr);
+  cerr << "done." << endl;
+
+  cout << "# Network: " << name << endl;
+  cout << "# node, sim, cdf, arr, |cdf - sim|, |arr - sim|" << endl;
+
+  double t_cdf = 0, t_arr = 0;
+  double e_cdf = 0, e_arr = 0;
+
+  BGL_FORALL_VERTICES(j, g, Graph)
+    {
+      // The distribution of the number of packets in transit.
+      distro in_transit;
+      BGL_FORALL_VERTICES(i, g, Graph)
+        if (i != j)
+          in_transit += sum(node_dist_poly(j, i, sim_ppm, false));
+
+      distro apd = poisson(in_transit.mean());
+      int v = get_output_capacity(g, j);
+
+      // The rates of the packets asking admission, and the rate of
+      // the admitted packets in the simulation.
+      double beta = 0, sim_beta_prime = 0;
+      BGL_FORALL_VERTICES(i, g, Graph)
+        if (i != j && tm.exists(i, j))
+          {
+            beta += tm.at(i, j);
+            sim_beta_prime += get_adm_distro(sim_ppm, j, i).mean();
+          }
+
+      if (beta == 0)
+        continue;
+
+      double r_cdf, r_arr;
+
+      clock_t start = clock();
+      for(int r = 0; r < REPEAT; ++r)
+        r_cdf = admit_ratio_cdf(apd, v, beta);
+      t_cdf += double(clock() - start) / CLOCKS_PER_SEC;
+
+      start = clock();
+      for(int r = 0; r < REPEAT; ++r)
+        r_arr = admit_ratio_arr(apd, v, beta);
+      t_arr += double(clock() - start) / CLOCKS_PER_SEC;
+
+      double sim = sim_beta_prime / beta;
+      e_cdf += fabs(r_cdf - sim);
+      e_arr += fabs(r_arr - sim);
+
+      cout << get(vertex_name, g, j) << " " << sim << " "
+           << r_cdf << " " << r_arr << " "
+           << fabs(r_cdf - sim) << " " << fabs(r_arr - sim) << endl;
+    }
+
+  cout << "# Total error: cdf " << e_cdf << ", arr " << e_arr << endl;
+  cout << "# Time [s]: cdf " << t_cdf << ", arr " << t_arr << endl;
+  cout << endl;
+
+  return 0;
+}
+
+int
+main (int argc, char* argv[])
+{
+  cout.flags(ios::fixed);
+  cout.precision(6);
+
+  // The hop and distance limits are the ones of the *.run files.
+  return bench("six_node_net", 5, 1000) ||
+    bench("random", 20, 1500) ||
+    bench("pionier", 20, 1500);
+}
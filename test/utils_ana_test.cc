@@ -0,0 +1,97 @@
+#include "distro.hpp"
+#include "geometric.hpp"
+#include "poisson.hpp"
+#include "tabdistro.hpp"
+#include "test.hpp"
+#include "utils_ana.hpp"
+
+#include <gsl/gsl_randist.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+// This tests the admission utilities from utils_ana.hpp.
+
+using namespace std;
+
+int
+main()
+{
+  // The exact ratio of the admitted packets should be about the same
+  // as the one calculated with the arrangements, which is truncated.
+  {
+    distro apd = poisson(7.3);
+
+    for(int v = 1; v <= 20; ++v)
+      {
+        double r_cdf = admit_ratio_cdf(apd, v, 2.1);
+        double r_arr = admit_ratio_arr(apd, v, 2.1);
+        TEST(r_cdf >= 0 && r_cdf <= 1);
+        TEST(fabs(r_cdf - r_arr) < 1e-2);
+      }
+  }
+
+  // For the geometric distribution, which has no packets in transit
+  // with probability 0 and a long tail, the arrangements are
+  // truncated too much, and so we compare the ratio with the one
+  // summed up over all the values that matter.
+  {
+    distro apd = geometric(0.2);
+    double beta = 3.5;
+
+    for(int v = 1; v <= 20; ++v)
+      {
+        // The average number of admitted packets.
+        double beta_prime = 0;
+        for(int a = 0; a < v; ++a)
+          for(int b = 0; b < 100; ++b)
+            beta_prime += min(v - a, b) * apd.get_prob(a) *
+              gsl_ran_poisson_pdf(b, beta);
+
+        TEST(fabs(admit_ratio_cdf(apd, v, beta) -
+                  beta_prime / beta) < 1e-12);
+      }
+  }
+
+  // With no packets in transit, E[min(v, B)] for B ~ Poisson(beta).
+  // For v = 1 it's P(B > 0) = 1 - exp(-beta).
+  {
+    distro apd = nodistro();
+    double beta = 1.5;
+    TEST(fabs(admit_ratio_cdf(apd, 1, beta) * beta -
+              (1 - exp(-beta))) < 1e-12);
+  }
+
+  // No packets are admitted, when there are always at least v
+  // packets in transit.  This tabdistro takes the arrangements.
+  {
+    tabdistro t;
+    t.set_prob(make_pair(1.0, 5));
+    distro apd = t;
+
+    map<Vertex, double> betas;
+    betas[0] = 1;
+    betas[1] = 2;
+
+    map<Vertex, double> betas_prime = admit_ana(apd, 5, betas);
+    EXPECT(betas_prime[0], 0);
+    EXPECT(betas_prime[1], 0);
+  }
+
+  // The rates of the admitted packets are proportional to the rates
+  // of the packets asking admission.
+  {
+    distro apd = poisson(3);
+
+    map<Vertex, double> betas;
+    betas[0] = 1;
+    betas[1] = 2;
+
+    map<Vertex, double> betas_prime = admit_ana(apd, 4, betas);
+    TEST(betas_prime[0] > 0);
+    TEST(fabs(2 * betas_prime[0] - betas_prime[1]) < 1e-12);
+  }
+
+  return 0;
+}
@@ -3,7 +3,11 @@
 #include "utils_sim.hpp"
 #include "test.hpp"
 
+#include <cmath>
 #include <map>
+#include <vector>
+
+#include <gsl/gsl_cdf.h>
 
 using namespace std;
 
@@ -85,6 +89,55 @@ main()
     EXPECT(calc_nr_in_transit(pqv, 2, 10), 0);
   }
 
+  // The sent packets are delivered in the order they were sent.
+  {
+    vector<calendar_queue> pqv(3, calendar_queue(2));
+    sent_pkts sent;
+
+    // Both packets arrive at node 1 in time slot 10.
+    packet p1(0, 2, 10);
+    packet p2(0, 2, 10);
+
+    sent.push_back(make_pair(1, &p2));
+    sent.push_back(make_pair(1, &p1));
+    deliver_pkts(sent, pqv);
+
+    EXPECT(sent.empty(), true);
+    EXPECT(pqv[0].size(), 0);
+    EXPECT(pqv[1].size(), 2);
+
+    slot_pkts pkts;
+    pqv[1].pop(10, pkts);
+    EXPECT(pkts.size(), 2);
+    EXPECT(pkts[0], &p2);
+    EXPECT(pkts[1], &p1);
+  }
+
+  // Test the confidence intervals of link loads.
+  {
+    Graph g(3);
+    Edge e1 = add_edge(0, 1, g).first;
+    Edge e2 = add_edge(1, 2, g).first;
+
+    vector<map<Edge, double> > lls(2);
+    lls[0][e1] = 0.4;
+    lls[1][e1] = 0.6;
+    // Link e2 is not used in the second replication.
+    lls[0][e2] = 0.2;
+
+    map<Edge, pair<double, double> > ci;
+    calculate_ll_ci(lls, ci, 0.95);
+
+    // The standard deviation of the mean is 0.1 for both links.
+    double t = gsl_cdf_tdist_Pinv(0.975, 1);
+
+    EXPECT(ci.size(), 2);
+    TEST(fabs(ci[e1].first - 0.5) < 1e-9);
+    TEST(fabs(ci[e1].second - 0.1 * t) < 1e-9);
+    TEST(fabs(ci[e2].first - 0.1) < 1e-9);
+    TEST(fabs(ci[e2].second - 0.1 * t) < 1e-9);
+  }
+
   // Test count_poly.
   {
     count_map_poly cmp;
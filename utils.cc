@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <map>
 #include <vector>
 
 #include <boost/graph/connected_components.hpp>
@@ -43,8 +44,50 @@ void complete_graph(Graph &g)
     {
       vector<packet_prefs> v_prefs(num_vertices(g));
 
+      // The index of an out-edge of node j, by the target node.  If
+      // there are parallel edges, the first one is taken, as the
+      // edge function does.
+      map<Vertex, int> index;
+      int k = 0;
+      BGL_FORALL_OUTEDGES(j, e, g, Graph)
+        index.insert(make_pair(target(e, g), k++));
+
       BGL_FORALL_VERTICES(i, g, Graph)
-        v_prefs[i] = make_prefs(i, j, g);
+        {
+          packet_prefs &prefs = v_prefs[i];
+          prefs = make_prefs(i, j, g);
+
+          // Compile the preferences into the indexes of the edges.
+          for(packet_prefs::const_iterator
+                v = prefs.begin(); v != prefs.end(); ++v)
+            prefs.edges.push_back(index[*v]);
+        }
+
+      put(vertex_bundle, g, j, v_prefs);
+    }
+
+  // Here we compile the routing order of the destinations at node j
+  // into their ranks, which needs the preferences in place.
+  BGL_FORALL_VERTICES(j, g, Graph)
+    {
+      vector<packet_prefs> v_prefs = get(vertex_bundle, g, j);
+
+      vector<Vertex> order;
+      BGL_FORALL_VERTICES(i, g, Graph)
+        order.push_back(i);
+
+      rou_order cmp(g, j);
+      sort(order.begin(), order.end(), cmp);
+
+      // The destinations that rou_order can't tell apart get the
+      // same rank.
+      int rank = 0;
+      for(int k = 0; k < order.size(); ++k)
+        {
+          if (k && cmp(order[k - 1], order[k]))
+            ++rank;
+          v_prefs[order[k]].rank = rank;
+        }
 
       put(vertex_bundle, g, j, v_prefs);
     }
@@ -192,6 +235,17 @@ get_output_capacity(const Graph& g, Vertex j)
   return v;
 }
 
+int
+get_max_link_distance(const Graph& g)
+{
+  int d = 0;
+
+  BGL_FORALL_EDGES(edge, g, Graph)
+    d = max(d, get(edge_weight, g, edge));
+
+  return d;
+}
+
 std::string
 path_to_string(Vertex i, Vertex j, const Graph &g)
 {
@@ -597,6 +651,22 @@ calculate_ll(const pt_matrix &ptm, map<Edge, double> &ll, const Graph &g)
     i->second /= get(edge_weight2, g, i->first);
 }
 
+double
+calculate_delivered(const packet_trajectory &pt, Vertex i, const Graph &g)
+{
+  double rate = 0;
+
+  // Iterate over the hops of the trajectory.
+  for(packet_trajectory::const_iterator t = pt.begin(); t != pt.end(); ++t)
+    // Iterate over the links of the hop.
+    for(packet_trajectory::mapped_type::const_iterator
+          l = t->second.begin(); l != t->second.end(); ++l)
+      if (target(l->first, g) == i)
+        rate += sum(l->second).mean();
+
+  return rate;
+}
+
 dist_poly
 node_dist_poly(Vertex j, Vertex i, const pp_matrix &ppm, bool admitted)
 {
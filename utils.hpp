@@ -40,7 +40,9 @@
  * This function calculates the shortes paths and packet preferences.
  * The data for shortest paths are stored in vertex_distance and
  * vertex_predecessor.  The data for the packet preferences are stored
- * in the vertex_bundle property.
+ * in the vertex_bundle property.  The preferences are also compiled
+ * into the indexes of out-edges and the routing ranks, which the
+ * route_arr function needs.
  */
 void
 complete_graph(Graph &g);
@@ -161,6 +163,14 @@ get_distance(Vertex i, Vertex j, const Graph &g);
 int
 get_output_capacity(const Graph& g, Vertex j);
 
+/**
+ * Returns the largest distance of a link in graph g.  In simulation
+ * the distance of a link is the number of time slots a packet
+ * travels along the link.
+ */
+int
+get_max_link_distance(const Graph& g);
+
 std::string
 path_to_string(Vertex i, Vertex j, const Graph &g);
 
@@ -255,6 +265,13 @@ print_output(const pp_matrix &ppm, const pt_matrix &ptm,
 void
 calculate_ll(const pt_matrix &ptm, map<Edge, double> &ll, const Graph &g);
 
+/**
+ * Returns the rate of the packets of the trajectory pt that are
+ * delivered to node i, i.e. that traverse the links to node i.
+ */
+double
+calculate_delivered(const packet_trajectory &pt, Vertex i, const Graph &g);
+
 /**
  * Returns a dist_poly for packets that arrive at node j and that are
  * destined to node i.  If the flag admitted is true, we also consider
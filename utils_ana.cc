@@ -3,7 +3,6 @@
 #include "nodistro.hpp"
 #include "poisson.hpp"
 #include "polynomial.hpp"
-#include "rou_order.hpp"
 #include "utils.hpp"
 #include "utils_ana.hpp"
 
@@ -11,6 +10,8 @@
 #include <ctime>
 #include <queue>
 
+#include <gsl/gsl_cdf.h>
+
 
 void
 make_hop(const Graph &g, const map<Vertex, dist_poly> &v,
@@ -57,31 +58,57 @@ make_hop(const Graph &g, const map<Vertex, dist_poly> &v,
 }
 
 
-map<Vertex, double>
-admit_ana(distro& apd, int v, const map<Vertex, double> &betas)
+void
+make_hop(const Graph &g, const vector<dist_poly> &v,
+         const csr_trans_matrix &T, vector<dist_poly> &result,
+         map<Edge, dist_poly> &used_links)
 {
+  assert(result.size() == v.size());
+
+  // Here we iterate over the rows of the matrix.
+  for(size_t r = 0; r < T.rows(); ++r)
+    {
+      Vertex i = T.key(r);
+
+      // Here we iterate over the columns of the row.
+      for(csr_trans_matrix::const_iterator
+            j = T.begin(r); j != T.end(r); ++j)
+        {
+          const dist_poly &pp = v[j->first];
+
+          if (pp.empty())
+            continue;
+
+          dist_poly over_link = j->second * pp;
+
+          // We don't bother if no transition is made.
+          if (!over_link.empty())
+            {
+              result[i] += over_link;
+
+              Edge e = edge(j->first, i, g).first;
+              used_links[e] += over_link;
+            }
+        }
+    }
+}
+
+double
+admit_ratio_arr(const distro &apd, int v, double beta)
+{
+  assert(beta > 0);
+
   // This is the distribution vector used for generating packets.
   vector<distro> distros;
   distros.push_back(apd);
+  distros.push_back(poisson(beta));
 
-  // This is the total number of packets that ask admission.
-  {
-    double beta = 0;
-    for(map<Vertex, double>::const_iterator
-	  i = betas.begin(); i != betas.end(); ++i)
-      beta += i->second;
-    
-    if (beta == 0)
-      distros.push_back(nodistro());
-    else
-      distros.push_back(poisson(beta));
-  }
-  
   // This is the average number of admitted packets.
   double beta_prime = 0;
 
-  // This is the average number of packets asking admission.
-  double beta = 0;
+  // This is the average number of packets asking admission, as seen
+  // in the arrangements processed.
+  double beta_arr = 0;
 
   // The queue of arrangements with the given distros.
   arr_queue q(distros);
@@ -102,13 +129,54 @@ admit_ana(distro& apd, int v, const map<Vertex, double> &betas)
       int b_prime = min(r, b);
 
       beta_prime += b_prime * prob;
-      beta += b * prob;
+      beta_arr += b * prob;
+    }
+
+  return beta_arr > 0 ? beta_prime / beta_arr : 0;
+}
+
+
+double
+admit_ratio_cdf(const distro &apd, int v, double beta)
+{
+  assert(beta > 0);
+
+  // This is the average number of admitted packets.
+  double beta_prime = 0;
+
+  // The average number of packets admitted when there are r output
+  // slots left: E[min(r, B)] = sum_{k = 0}^{r - 1} P(B > k).  We
+  // accumulate it as r grows.  When there are a packets in transit,
+  // there are r = v - a slots left, and so for a >= v no packets are
+  // admitted.
+  double e_min = 0;
+  for(int r = 1; r <= v; ++r)
+    {
+      e_min += gsl_cdf_poisson_Q(r - 1, beta);
+      beta_prime += apd.get_prob(v - r) * e_min;
     }
 
+  return beta_prime / beta;
+}
+
+
+map<Vertex, double>
+admit_ana(distro& apd, int v, const map<Vertex, double> &betas)
+{
+  // This is the total number of packets that ask admission.
+  double beta = 0;
+  for(map<Vertex, double>::const_iterator
+        i = betas.begin(); i != betas.end(); ++i)
+    beta += i->second;
+
+  // The ratio of the admitted packets.  For the tabular distributions
+  // we process the arrangements, because their probabilities are
+  // known only for the values in the table anyway.
   double rho = 0;
 
-  if (beta > 0) 
-    rho = beta_prime / beta;
+  if (beta > 0)
+    rho = apd.is_tabdistro() ? admit_ratio_arr(apd, v, beta) :
+      admit_ratio_cdf(apd, v, beta);
 
   // This is the returned object.
   map<Vertex, double> betas_prime;
@@ -135,83 +203,125 @@ admit_ana_distro(distro &apd, int v, const map<Vertex, double> &betas)
 }
 
 
+/**
+ * Orders the (rank, index) pairs of destinations by their ranks only,
+ * so that the destinations are routed in the order of rou_order.
+ */
+struct rank_order
+{
+  bool operator()(const pair<int, int> &a, const pair<int, int> &b) const
+  {
+    return a.first < b.first;
+  }
+};
+
+
 void
 route_arr(const Graph &g, Vertex j, const map<Vertex, int> &arr,
           edge_count_map &count)
 {
   // We want an empty object that we are supposed to fill in.
   assert(count.empty());
-  
-  // This avail map stores the number of wavelengths left on each edge
-  // that leaves node j.
-  map<Edge, int> avail;
+
+  // The compiled preferences of packets at node j.
+  const vector<packet_prefs> &j_prefs = get(vertex_bundle, g, j);
+
+  // The out-edges of node j, and the number of wavelengths left on
+  // them, indexed the way the compiled preferences are.
+  vector<Edge> edges;
+  vector<int> avail;
   BGL_FORALL_OUTEDGES(j, edge, g, Graph)
-    avail[edge]= get(edge_weight2, g, edge);
+    {
+      edges.push_back(edge);
+      avail.push_back(get(edge_weight2, g, edge));
+    }
+
+  // The destinations and their numbers of packets.
+  vector<pair<Vertex, int> > dests(arr.begin(), arr.end());
 
   // We route packets depending only on their destination node.  We
-  // get the right order with this priority queue.
-  priority_queue<Vertex, vector<Vertex>, rou_order> q(rou_order(g, j));
-  for(map<Vertex, int>::const_iterator i = arr.begin(); i != arr.end(); ++i)
-    q.push(i->first);
+  // get the right order with this priority queue of the ranks of the
+  // destinations, which are ordered the way rou_order orders them.
+  priority_queue<pair<int, int>, vector<pair<int, int> >, rank_order> q;
+  for(int d = 0; d < dests.size(); ++d)
+    q.push(make_pair(j_prefs[dests[d].first].rank, d));
+
+  // The number of packets routed along the out-edges.
+  vector<int> routed(edges.size());
 
   // We route one entry of arr per one iteration of this loop.
   while(!q.empty())
     {
-      // This is the destination node of packets.
-      Vertex i = q.top();
+      // This is the destination node of packets, and the number of
+      // packets that go there.
+      Vertex i = dests[q.top().second].first;
+      int np = dests[q.top().second].second;
       q.pop();
-      
-      // The number of packets that go to node i.
-      map<Vertex, int>::const_iterator iter = arr.find(i);
-      assert(iter != arr.end());
-      int np = iter->second;
-      
+
+      // Preferences of packets at node j destined to node i.
+      const vector<int> &prefs = j_prefs[i].edges;
+      assert(prefs.size() == j_prefs[i].size());
+
       // We route one packet per one iteration of this loop.  There
       // are the count packets to route.
       while(np--)
-        {
-          // Preferences of packets at node j destined to node i.
-          const packet_prefs &prefs = get(vertex_bundle, g, j)[i];
-          
-          // Here we iterate over the packet preferences.  We start
-          // with the most desired packet preference.
-          for(packet_prefs::const_iterator
-                v = prefs.begin(); v != prefs.end(); ++v)
-            {
-              // Find the edge to which the packet preferences refer.
-              Edge e = edge(j, *v, g).first;
-              map<Edge, int>::iterator l = avail.find(e);
-              assert(l != avail.end());
-              
-              // We check if there is an available wavelength on
-              // that edge.  If so, we take the wavelength.
-              if (l->second)
-                {
-                  // We take one wavelength for the packet.
-                  l->second--;
-                  
-                  // In the result object we find the edge_probs
-                  // object for destination with index *i.
-                  ++count[i][e];
-                  
-                  break;
-                }
-            }
-        }
+        // Here we iterate over the packet preferences.  We start
+        // with the most desired packet preference.
+        for(int p = 0; p < prefs.size(); ++p)
+          {
+            int k = prefs[p];
+
+            // We check if there is an available wavelength on that
+            // edge.  If so, we take the wavelength.
+            if (avail[k])
+              {
+                --avail[k];
+                ++routed[k];
+                break;
+              }
+          }
+
+      // In the result object we put the packets routed to node i.
+      for(int k = 0; k < routed.size(); ++k)
+        if (routed[k])
+          {
+            count[i][edges[k]] = routed[k];
+            routed[k] = 0;
+          }
     }
 }
 
 
 void
-arr_route_prob(const Graph &g, Vertex j, const map<Vertex, int> &arr,
+route_arr(const Graph &g, Vertex j, const map<Vertex, int> &arr,
+          edge_count_map &count, route_cache &cache)
+{
+  route_cache::key_type k = route_cache::encode(arr);
+
+  if (const edge_count_map *c = cache.find(k))
+    {
+      assert(count.empty());
+      count = *c;
+    }
+  else
+    {
+      route_arr(g, j, arr, count);
+      cache.insert(k, count);
+    }
+}
+
+
+/**
+ * Turns the numbers of packets routed in arrangement arr into the
+ * routing probabilities.
+ */
+static void
+count_to_probs(const map<Vertex, int> &arr, const edge_count_map &count,
                edge_probs_map &probs)
 {
   // We want an empty return argument.
   assert(probs.empty());
 
-  edge_count_map count;
-  route_arr(g, j, arr, count);
-
   for(edge_count_map::const_iterator
         vi = count.begin(); vi != count.end(); ++vi)
     for(edge_count::const_iterator
@@ -226,8 +336,32 @@ arr_route_prob(const Graph &g, Vertex j, const map<Vertex, int> &arr,
 
 
 void
+arr_route_prob(const Graph &g, Vertex j, const map<Vertex, int> &arr,
+               edge_probs_map &probs)
+{
+  edge_count_map count;
+  route_arr(g, j, arr, count);
+  count_to_probs(arr, count, probs);
+}
+
+
+void
+arr_route_prob(const Graph &g, Vertex j, const map<Vertex, int> &arr,
+               edge_probs_map &probs, route_cache &cache)
+{
+  edge_count_map count;
+  route_arr(g, j, arr, count, cache);
+  count_to_probs(arr, count, probs);
+}
+
+
+/**
+ * Calculates the routing probabilities with analysis, and with the
+ * routing results cached if cache is not null.
+ */
+static void
 route_ana(const Graph &g, Vertex j, const map<Vertex, distro> &mus,
-          edge_probs_map &probs)
+          edge_probs_map &probs, route_cache *cache)
 {
   // We want an empty return argument.
   assert(probs.empty());
@@ -270,7 +404,10 @@ route_ana(const Graph &g, Vertex j, const map<Vertex, distro> &mus,
       // Here we calculate the probabilities that a packet is sent to
       // given outputs.
       edge_probs_map arr_probs;
-      arr_route_prob(g, j, arr, arr_probs);
+      if (cache)
+        arr_route_prob(g, j, arr, arr_probs, *cache);
+      else
+        arr_route_prob(g, j, arr, arr_probs);
 
       for(edge_probs_map::iterator
             vi = arr_probs.begin(); vi != arr_probs.end(); ++vi)
@@ -284,3 +421,19 @@ route_ana(const Graph &g, Vertex j, const map<Vertex, distro> &mus,
         vi = probs.begin(); vi != probs.end(); ++vi)
     vi->second *= 1.0 / aggr[vi->first];
 }
+
+
+void
+route_ana(const Graph &g, Vertex j, const map<Vertex, distro> &mus,
+          edge_probs_map &probs)
+{
+  route_ana(g, j, mus, probs, 0);
+}
+
+
+void
+route_ana(const Graph &g, Vertex j, const map<Vertex, distro> &mus,
+          edge_probs_map &probs, route_cache &cache)
+{
+  route_ana(g, j, mus, probs, &cache);
+}
@@ -5,8 +5,10 @@
 #include "edge_probs.hpp"
 #include "graph.hpp"
 #include "matrixes.hpp"
+#include "route_cache.hpp"
 
 #include <map>
+#include <vector>
 
 /**
  * Performs this operation: result = v * T
@@ -16,11 +18,47 @@ make_hop(const Graph &g, const map<Vertex, dist_poly> &v,
          const trans_matrix &T, map<Vertex, dist_poly> &result,
          map<Edge, dist_poly> &used_links);
 
+/**
+ * Performs this operation: result = v * T, where the vectors are
+ * dense, i.e. element v[j] is the polynomial of node j, and it's
+ * empty if there are no packets at node j.  The result has to be
+ * sized for all nodes and empty.
+ */
+void
+make_hop(const Graph &g, const vector<dist_poly> &v,
+         const csr_trans_matrix &T, vector<dist_poly> &result,
+         map<Edge, dist_poly> &used_links);
+
+/**
+ * Returns the ratio of the admitted packets, i.e. E[min(max(v - a,
+ * 0), b)] / E[b], where a is distributed with apd, and b with the
+ * Poisson distribution of mean beta.  The expectation is calculated
+ * by processing the arrangements of a and b, and so it's truncated.
+ *
+ * @param apd the distribution of the number of packets in transit
+ *
+ * @param v the output capacity of the node
+ *
+ * @param beta the mean rate of packets asking admission, positive
+ */
+double
+admit_ratio_arr(const distro &apd, int v, double beta);
+
+/**
+ * The same as above, but the expectation is calculated exactly in
+ * O(v) time with the CDF of the Poisson distribution.  We need the
+ * probabilities of apd for the values up to v.
+ */
+double
+admit_ratio_cdf(const distro &apd, int v, double beta);
+
 /**
  * This function calculates the average number of admitted packets
  * based on the average number of packets in transit alpha_prime, the
  * output capacity v, and the mean rates of demands given by beta.
  * The return value is the map of mean rates of the admitted packets.
+ * The ratio of the admitted packets is calculated with
+ * admit_ratio_cdf, or with admit_ratio_arr if apd is a tabdistro.
  *
  * @param apd the distribution of alpha_prime, i.e. the number
  * of packets in transit
@@ -66,6 +104,14 @@ void
 route_arr(const Graph &g, Vertex j, const map<Vertex, int> &arr,
           edge_count_map &count);
 
+/**
+ * The same as above, but the result is looked up in the cache of
+ * node j first, and cached if it's not there.
+ */
+void
+route_arr(const Graph &g, Vertex j, const map<Vertex, int> &arr,
+          edge_count_map &count, route_cache &cache);
+
 /**
  * This function calculates the probabilities of routing for packets
  * in a specific arrangement for node j.  The input are graph g, node
@@ -88,6 +134,14 @@ void
 arr_route_prob(const Graph &g, Vertex j, const map<Vertex, int> &arr,
                edge_probs_map &probs);
 
+/**
+ * The same as above, but with the routing results cached in the
+ * cache of node j.
+ */
+void
+arr_route_prob(const Graph &g, Vertex j, const map<Vertex, int> &arr,
+               edge_probs_map &probs, route_cache &cache);
+
 /**
  * This function calculates the routing probabilities with analysis.
  * As the input we need graph g and node j for which probabilities are
@@ -110,4 +164,13 @@ void
 route_ana(const Graph &g, Vertex j, const map<Vertex, distro> &mus,
           edge_probs_map &probs);
 
+/**
+ * The same as above, but with the routing results cached in the
+ * cache of node j.  The cache should be kept across the analytical
+ * iterations.
+ */
+void
+route_ana(const Graph &g, Vertex j, const map<Vertex, distro> &mus,
+          edge_probs_map &probs, route_cache &cache);
+
 #endif /* UTILS_ANA_HPP */
@@ -1,126 +1,92 @@
 #include "edge_probs.hpp"
 #include "polynomial.hpp"
-#include "rand.hpp"
 #include "tabdistro.hpp"
 #include "utils.hpp"
 #include "utils_ana.hpp"
 #include "utils_sim.hpp"
 
-#include <gsl/gsl_randist.h>
+#include <gsl/gsl_cdf.h>
 
+#include <algorithm>
+#include <cmath>
 #include <map>
+#include <set>
+#include <vector>
 
-void
-report_packet_presence(Vertex v, const packet &pkt, ppc_matrix &ppcm)
-{
-  // This is the packet presence of the demand.
-  packet_presence_count &ppc = ppcm[pkt.dst][pkt.src];
-
-  // The map of polynomials ppmap describe where packets reside after
-  // they made hop number pkt.hops.
-  map<Vertex, count_poly> &v2cp = ppc[pkt.hops];
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics/stats.hpp>
+#include <boost/accumulators/statistics/mean.hpp>
+#include <boost/accumulators/statistics/variance.hpp>
 
-  // This is the delay the packet incurred in the network.
-  int delay = pkt.next_ts - pkt.start_ts;
-
-  // Here we finally fill in the right info.
-  v2cp[v][delay]++;
-}
-
-void
-report_packet_transition(Edge e, const packet &pkt, ptc_matrix &ptcm)
-{
-  // This is the packet trajectory of the demand.
-  packet_trajectory_count &pt = ptcm[pkt.dst][pkt.src];
-
-  // The map of polynomials ptmap describe what links packets take
-  // during the hop number pkt.hops.
-  map<Edge, count_poly> &e2cp = pt[pkt.hops];
-
-  // This is the delay the packet incurred in the network.
-  int delay = pkt.next_ts - pkt.start_ts;
-
-  // Here we finally fill in the right info.
-  e2cp[e][delay]++;
-}
+using namespace boost::accumulators;
 
 void
 process_packets(const Graph &g, Vertex j, timeslot ts,
-                map<Vertex, waiting_pkts> &pqv,
-                waiting_pkts &local_add, waiting_pkts &local_drop,
-                ppcm_matrix &ppcmm, ptcm_matrix &ptcmm,
-                int HL, int DL)
+                calendar_queue &wp, sent_pkts &sent,
+                slot_pkts &local_add, slot_pkts &local_drop,
+                sim_stats &stats, int HL, int DL, stream_rng &rng,
+                packet_pool &pool)
 {
-  // This is the reference to the queue of packets that wait to be
-  // processed.
-  waiting_pkts &wp = pqv[j];
-
-  // Keeps the number of packets that visited node j.
-  ppc_matrix ppcm;
-
-  // Keeps the number of packets that traversed links leaving node j.
-  ptc_matrix ptcm;
-
   // These are packets that will be processed in this timeslot.
-  waiting_pkts to_route;
+  slot_pkts to_route;
 
-  // Here we find the packets, which arrived from neighbor nodes.
-  waiting_pkts::iterator first = wp.begin();
-  waiting_pkts::iterator last = find_waiting_pkts(wp, ts);
-  to_route.insert(first, last);
-  wp.erase(first, last);
+  // Here we take the packets, which arrived from neighbor nodes.
+  wp.pop(ts, to_route);
 
   // Now we report these packets arrived at node j.
-  for(waiting_pkts::iterator k = to_route.begin(); k != to_route.end(); ++k)
-    report_packet_presence(j, **k, ppcm);
+  for(slot_pkts::iterator k = to_route.begin(); k != to_route.end(); ++k)
+    stats.report_presence(j, **k);
 
   // In the to_route structure there can be packts which are destined
   // to this node, and so we need to move them to local_drop.  In
   // to_route there are now only packets that came from other nodes.
-  for(waiting_pkts::iterator k = to_route.begin(); k != to_route.end();)
-    {
-      // We need to play this way with iterators because we can remove
-      // the entry pointed out by this iterator, which invalidates the
-      // iterator.
-      waiting_pkts::iterator l = k;
-      k++;
-
-      if ((*l)->dst == j)
-        {
-          // This packet is destined to this node, so add it to
-          // local_drop and remove it from to_route.
-          local_drop.insert(*l);
-          to_route.erase(l);
-        }
-    }
+  // The packets that stay in to_route keep their order.
+  slot_pkts::iterator l = to_route.begin();
+  for(slot_pkts::iterator k = to_route.begin(); k != to_route.end(); ++k)
+    if ((*k)->dst == j)
+      // This packet is destined to this node, so add it to
+      // local_drop.
+      local_drop.push_back(*k);
+    else
+      *l++ = *k;
+  to_route.erase(l, to_route.end());
 
   // Then if there are any outputs left, then we add the local_add
   // packets into the to_route structure.  But first we need to know
-  // how many more packets we can add, and in the loop below we do it.
-  // "j" is the current node, "edge" is the outgoing edge, "g" is the
-  // graph.
+  // how many more packets we can add.  "j" is the current node, "g"
+  // is the graph.
   int v = get_output_capacity(g, j);
-
-  // In every iteration of the loop we chose at random one packet from
-  // local_add and move it to to_route.  We repeat this as many times
-  // as we can.
-  while(!local_add.empty() && to_route.size() < v)
+  int n = local_add.size();
+  int m = min(max(v - int(to_route.size()), 0), n);
+
+  // We choose at random m packets of local_add with the partial
+  // Fisher-Yates shuffle: the k-th packet is drawn from the packets
+  // not chosen yet, and swapped to position k.  It takes constant
+  // time per packet, and the chosen packets are the first m.
+  to_route.reserve(to_route.size() + m);
+  for(int k = 0; k < m; ++k)
     {
-      waiting_pkts::iterator k = local_add.begin();
-      advance(k, myrand(local_add.size()));
+      int r = k + rng.uniform_int(n - k);
+      swap(local_add[k], local_add[r]);
 
       // We report the newly admitted packets.
-      report_packet_presence(j, **k, ppcm);
+      stats.report_presence(j, *local_add[k]);
+      stats.report_admitted(*local_add[k]);
 
-      to_route.insert(*k);
-      local_add.erase(k);
+      to_route.push_back(local_add[k]);
     }
 
+  // The packets left in local_add are rejected, and the caller
+  // releases them.
+  for(int k = m; k < n; ++k)
+    stats.report_rejected(*local_add[k]);
+  local_add.erase(local_add.begin(), local_add.begin() + m);
+
   // We know what packets to send: all the ones from the to_route
   // structure.  But we have to translate these packets into a
   // structure that we can pass for routing.
   map<Vertex, int> arr;
-  for(waiting_pkts::iterator i = to_route.begin(); i != to_route.end(); i++)
+  for(slot_pkts::iterator i = to_route.begin(); i != to_route.end(); i++)
     arr[(*i)->dst]++;
 
   edge_count_map result;
@@ -130,11 +96,10 @@ process_packets(const Graph &g, Vertex j, timeslot ts,
   // and put them in the right place in the "pqv" structure again.
   // Now we route packets according to what we find in object
   // "result".
-  while(!to_route.empty())
+  for(slot_pkts::iterator i = to_route.begin(); i != to_route.end(); i++)
     {
-      // Get the first element from the to_route structure.
-      packet *pkt = *(to_route.begin());
-      to_route.erase(to_route.begin());
+      // Get the next element from the to_route structure.
+      packet *pkt = *i;
 
       // The edge_count for the destination node of packet pkt.
       edge_count &ecm = result[pkt->dst];
@@ -147,7 +112,7 @@ process_packets(const Graph &g, Vertex j, timeslot ts,
       // Check whether the we can route the packet.
       if (ei == ecm.end())
         // Drop the packet since we found no available wavelength.
-        delete pkt;
+        pool.release(pkt);
       else
         {
           // Take one wavelength on this edge.
@@ -181,20 +146,138 @@ process_packets(const Graph &g, Vertex j, timeslot ts,
           // wasn't greater than DL.
           if (pkt->hops > HL || len > DL)
             // Remove the packet
-            delete pkt;
+            pool.release(pkt);
           else
             {
-              // Now "send" the packet to the next node.
-              pqv[target(e, g)].insert(pkt);
+              // Now "send" the packet to the next node.  The caller
+              // puts it into the queue of that node.
+              sent.push_back(make_pair(target(e, g), pkt));
 
               // Report the transition of the packet along link e.
-              report_packet_transition(e, *pkt, ptcm);
+              stats.report_transition(e, *pkt);
             }
         }
     }
 
-  ppcmm += ppcm;
-  ptcmm += ptcm;
+  // The node is done with this time slot.
+  stats.close_slot();
+}
+
+void
+simulate_node(const Graph &g, Vertex j, timeslot ts,
+              const demand_table &dt, calendar_queue &wp, sent_pkts &sent,
+              unsigned long seed, packet_pool &pool, sim_stats &stats,
+              int HL, int DL, generation_type gen)
+{
+  // The streams of node j for this time slot.  The generation and
+  // the admission have their own streams, so that the numbers drawn
+  // for one don't shift the numbers drawn for the other.
+  stream_rng gen_rng(seed, j, ts, stream_rng::GENERATION);
+  stream_rng adm_rng(seed, j, ts, stream_rng::ADMISSION);
+
+  // These are the local packets that ask for admission.
+  slot_pkts local_add;
+
+  // These are the packets for which this packet is the destination.
+  slot_pkts local_drop;
+
+  // We generate the local packets that ask for admission, for all
+  // the demands of node j at once.
+  if (gen == gen_any)
+    dt.generate(j, ts, local_add, gen_rng, pool);
+  else if (gen == gen_active)
+    dt.generate_active(j, ts, local_add, gen_rng, pool);
+  stats.report_offered(local_add.size());
+
+  // This function does all the packet processing.
+  process_packets(g, j, ts, wp, sent, local_add, local_drop,
+                  stats, HL, DL, adm_rng, pool);
+
+  // Here we process the packets that asked for admission, but were
+  // jilted.  We simply release them.
+  release_pkts(local_add, pool);
+
+  // Here we process the packets that are arriving at the
+  // destination, i.e. packets that we find in local_drop.
+  stats.report_delivered(local_drop.size());
+  release_pkts(local_drop, pool);
+}
+
+void
+deliver_pkts(sent_pkts &sent, vector<calendar_queue> &pqv)
+{
+  for(sent_pkts::iterator i = sent.begin(); i != sent.end(); ++i)
+    pqv[i->first].insert(i->second);
+
+  sent.clear();
+}
+
+void
+calculate_ll_ci(const vector<map<Edge, double> > &lls,
+                map<Edge, pair<double, double> > &ci, double level)
+{
+  assert(lls.size() >= 2);
+  assert(ci.empty());
+
+  // These are the edges used in any replication.
+  set<Edge> present;
+  for(int r = 0; r < lls.size(); ++r)
+    for(map<Edge, double>::const_iterator
+          i = lls[r].begin(); i != lls[r].end(); ++i)
+      present.insert(i->first);
+
+  // The quantile of the Student's t-distribution.
+  int n = lls.size();
+  double t = gsl_cdf_tdist_Pinv((1 + level) / 2, n - 1);
+
+  for(set<Edge>::iterator e = present.begin(); e != present.end(); ++e)
+    {
+      accumulator_set<double, stats<tag::mean, tag::variance> > acc;
+
+      for(int r = 0; r < n; ++r)
+        {
+          map<Edge, double>::const_iterator i = lls[r].find(*e);
+          acc(i != lls[r].end() ? i->second : 0);
+        }
+
+      // The variance of the accumulator is biased, and so we correct
+      // it to get the sample variance.
+      double s2 = accumulators::variance(acc) * n / (n - 1);
+      ci[*e] = make_pair(mean(acc), t * sqrt(s2 / n));
+    }
+}
+
+void
+print_admissions(const adm_matrix &am, const Graph &g, std::ostream &os)
+{
+  os << "******************************************************\n";
+  os << "ADMISSIONS\n";
+  os << "******************************************************\n";
+
+  FOREACH_MATRIX_ELEMENT(am, i, j, e, adm_matrix)
+    {
+      boost::uint64_t offered = e.first + e.second;
+
+      os << "Demand " << get(vertex_name, g, j) << " -> "
+         << get(vertex_name, g, i) << ": "
+         << e.first << " admitted, " << e.second << " rejected ("
+         << 100.0 * e.second / offered << "%)\n";
+    }
+}
+
+void
+print_ll_ci(const map<Edge, pair<double, double> > &ci, double level,
+            const Graph &g, std::ostream &os)
+{
+  os << "******************************************************\n";
+  os << "LINK LOADS WITH " << 100 * level << "% CONFIDENCE INTERVALS\n";
+  os << "******************************************************\n";
+
+  for(map<Edge, pair<double, double> >::const_iterator
+        i = ci.begin(); i != ci.end(); ++i)
+    os << "Link " << to_string(i->first, g) << ": "
+       << 100 * i->second.first << "% +- "
+       << 100 * i->second.second << "%\n";
 }
 
 int
@@ -223,39 +306,12 @@ calc_nr_in_transit(const map<Vertex, waiting_pkts> &pqv,
 }
 
 void
-delete_waiting_pkts(waiting_pkts &wp)
+release_pkts(slot_pkts &pkts, packet_pool &pool)
 {
-  while(!wp.empty())
-    {
-      waiting_pkts::iterator i = wp.begin();
-      delete *i;
-      wp.erase(i);
-    }
-}
+  for(slot_pkts::iterator i = pkts.begin(); i != pkts.end(); ++i)
+    pool.release(*i);
 
-void
-fill_local_add(waiting_pkts &local_add, Vertex j, Vertex i,
-               timeslot ts, const fp_matrix &tm, gsl_rng *rng)
-{
-  if (tm.exists(i, j))
-    {
-      double rate = tm.at(i, j);
-      assert(rate != 0);
-
-      // This is the number of packets that ask for admission at node
-      // j and want to go to node i.  This number of packets is for a
-      // single slot only.  Packets ask for admission with the Poisson
-      // distribution.  The mean number of packets is taken from the
-      // traffic matrix tm.
-      int number = gsl_ran_poisson(rng, rate);
-
-      // Here we add these packets to the local_add queue.
-      while(number--)
-        {
-          packet *pkt = new packet(j, i, ts);
-          local_add.insert(pkt);
-        }
-    }
+  pkts.clear();
 }
 
 void
@@ -299,46 +355,13 @@ cmp2dp(const count_map_poly &cmp, dist_poly &dp, int time_slots)
 {
   for(count_map_poly::const_iterator i = cmp.begin(); i != cmp.end(); ++i)
     {
-      tabdistro td;
+      // Element probs[c] is the probability of c packets.
+      vector<double> probs;
+      if (!i->second.empty())
+        probs.resize(i->second.rbegin()->first + 1);
       for(count_map_poly::mapped_type::const_iterator
             j = i->second.begin(); j != i->second.end(); ++j)
-        td.set_prob(make_pair((double)j->second / time_slots, j->first));
-      dp[i->first] = td;
+        probs[j->first] = (double)j->second / time_slots;
+      dp[i->first] = tabdistro(probs);
     }
 }
-
-ppcm_matrix &
-operator += (ppcm_matrix &ppcmm, const ppc_matrix &ppcm)
-{
-  // Iterate over the elements of the matrix.
-  FOREACH_MATRIX_ELEMENT(ppcm, i, j, ppc, ppc_matrix)
-    // Iterate over hops
-    for(packet_presence_count::const_iterator
-          hi = ppc.begin(); hi != ppc.end(); ++hi)
-      // Iterate over vertexes
-      for(packet_presence_count::mapped_type::const_iterator
-            vi = hi->second.begin(); vi != hi->second.end(); ++vi)
-        for(count_poly::const_iterator
-              di = vi->second.begin(); di != vi->second.end(); ++di)
-          ++(ppcmm[i][j][hi->first][vi->first][di->first][di->second]);
-
-  return ppcmm;
-}
-
-ptcm_matrix &
-operator += (ptcm_matrix &ptcmm, const ptc_matrix &ptcm)
-{
-  // Iterate over the elements of the matrix.
-  FOREACH_MATRIX_ELEMENT(ptcm, i, j, ptc, ptc_matrix)
-    // Iterate over hops
-    for(packet_trajectory_count::const_iterator
-          hi = ptc.begin(); hi != ptc.end(); ++hi)
-      // Iterate over edges
-      for(packet_trajectory_count::mapped_type::const_iterator
-            vi = hi->second.begin(); vi != hi->second.end(); ++vi)
-        for(count_poly::const_iterator
-              di = vi->second.begin(); di != vi->second.end(); ++di)
-          ++(ptcmm[i][j][hi->first][vi->first][di->first][di->second]);
-
-  return ptcmm;
-}
@@ -1,45 +1,122 @@
 #ifndef UTILS_SIM_HPP
 #define UTILS_SIM_HPP
 
+#include "calendar_queue.hpp"
+#include "demand_table.hpp"
 #include "edge_probs.hpp"
 #include "graph.hpp"
 #include "matrixes.hpp"
 #include "distro.hpp"
+#include "packet_pool.hpp"
+#include "rand.hpp"
+#include "sim_stats.hpp"
 
 #include <map>
+#include <vector>
 
-#include <gsl/gsl_rng.h>
+/**
+ * This function is called to process packets at a node.  This
+ * function is called for a single node -- the node where packets are
+ * routed.
+ *
+ * The function knows how to route the packets, because it knows the
+ * network topology with the g parameter.
+ *
+ * The local packets are admitted at random, as many as there are
+ * outputs left after the transit packets.  The admitted packets are
+ * removed from local_add, and the rejected ones are left there.
+ *
+ * The function touches only the queue wp of node j.  The packets
+ * that node j sends to its neighbors are not put into their queues,
+ * but are appended to sent, and the caller delivers them with
+ * function deliver_pkts.
+ *
+ * @param wp the queue of packets that arrive at node j
+ *
+ * @param sent the packets that node j sends
+ *
+ * @param stats the statistics where the packet events are reported
+ *
+ * @param rng the admission stream of node j for time slot ts
+ *
+ * @param pool the pool where the dropped packets are released
+ */
+void
+process_packets(const Graph &g, Vertex j, timeslot ts,
+                calendar_queue &wp, sent_pkts &sent,
+                slot_pkts &local_add, slot_pkts &local_drop,
+                sim_stats &stats, int HL, int DL, stream_rng &rng,
+                packet_pool &pool);
 
 /**
- * We use this function to report the presence of packets.  This
- * function fills in the matrix of packet presence.  The packet pkt is
- * present at node v.
+ * How simulate_node generates the local packets: for any time slot,
+ * for a time slot known to have packets, or not at all.
+ */
+enum generation_type {gen_any, gen_active, gen_none};
+
+/**
+ * Simulates node j during the time slot ts: generates the local
+ * packets, processes packets with function process_packets, and
+ * deletes the rejected and delivered packets.
+ *
+ * @param dt the demands of the traffic matrix
+ *
+ * @param wp the queue of packets that arrive at node j
+ *
+ * @param sent the packets that node j sends
+ *
+ * @param seed the seed of the random number streams
+ *
+ * @param pool the pool of packets of the calling thread
+ *
+ * @param gen how to generate the local packets
  */
 void
-report_packet_presence(Vertex v, const packet &pkt, ppc_matrix &ppcm);
+simulate_node(const Graph &g, Vertex j, timeslot ts,
+              const demand_table &dt, calendar_queue &wp, sent_pkts &sent,
+              unsigned long seed, packet_pool &pool, sim_stats &stats,
+              int HL, int DL, generation_type gen = gen_any);
 
 /**
- * We use this function to report the transition of packets.  This
- * function fills in the matrix of packet trajectories.  The packet
- * pkt transits along link e.
+ * Puts the sent packets into the queues of the nodes they were sent
+ * to.  The packets are put in the order they were sent.  The sent
+ * structure is cleared.
+ *
+ * @param sent the packets to deliver
+ *
+ * @param pqv the packet queue per vertex
  */
 void
-report_packet_transition(Edge e, const packet &pkt, ptc_matrix &ptcm);
+deliver_pkts(sent_pkts &sent, vector<calendar_queue> &pqv);
 
 /**
- * This function is called to process packets at a node.  This
- * function is called for a single node -- the node where packets are
- * routed.
+ * Calculates the confidence intervals of the link loads of
+ * independent replications.  A link not present in a replication has
+ * the zero load in that replication.
  *
- * The function knows how to route the packets, because it knows the
- * network topology with the g parameter.
+ * @param lls the link loads of the replications, at least two
+ *
+ * @param ci the means and half-widths of the intervals
+ *
+ * @param level the confidence level, e.g. 0.95
  */
 void
-process_packets(const Graph &g, Vertex j, timeslot ts,
-                map<Vertex, waiting_pkts> &pqv,
-                waiting_pkts &local_add, waiting_pkts &local_drop,
-                ppcm_matrix &ppcmm, ptcm_matrix &ptcmm,
-                int HL, int DL);
+calculate_ll_ci(const vector<map<Edge, double> > &lls,
+                map<Edge, pair<double, double> > &ci, double level);
+
+/**
+ * This function prints the confidence intervals of the link loads.
+ */
+void
+print_ll_ci(const map<Edge, pair<double, double> > &ci, double level,
+            const Graph &g, std::ostream &os);
+
+/**
+ * This function prints the numbers of packets admitted and rejected
+ * per demand.
+ */
+void
+print_admissions(const adm_matrix &am, const Graph &g, std::ostream &os);
 
 /**
  * Calculates the number of packets in transit at node j during the
@@ -59,31 +136,14 @@ calc_nr_in_transit(const map<Vertex, waiting_pkts> &pqv,
                    Vertex j, timeslot ts);
 
 /**
- * Deletes the packets from the given structure.
+ * Releases the packets to the pool, and clears the structure.
  *
- * @param wp the structure with packets to delete
- */
-void
-delete_waiting_pkts(waiting_pkts &wp);
-
-/**
- * Put the packets into the local_add queue.
- *
- * @param local_add the place where packets will be put
- *
- * @param j the current node
- *
- * @param i the destination node
- *
- * @param ts the time slot
+ * @param pkts the structure with packets to release
  *
- * @param tm the traffic matrix
- *
- * @param rng the random number generator
+ * @param pool the pool to release the packets to
  */
 void
-fill_local_add(waiting_pkts &local_add, Vertex j, Vertex i,
-	       timeslot ts, const fp_matrix &tm, gsl_rng *rng);
+release_pkts(slot_pkts &pkts, packet_pool &pool);
 
 /**
  * This function converts a ppcm_matrix to pp_matrix.
@@ -103,16 +163,4 @@ ptcmm2ptm(const ptcm_matrix &ptcmm, pt_matrix &ptm, int time_slots);
 void
 cmp2dp(const count_map_poly &cp, dist_poly &dp, int time_slots);
 
-/**
- * Adds to the ppcm_matrix object the ppc_matrix object.
- */
-ppcm_matrix &
-operator += (ppcm_matrix &ppcmm, const ppc_matrix &ppcm);
-
-/**
- * Adds to the ptcm_matrix object the ptc_matrix object.
- */
-ptcm_matrix &
-operator += (ptcm_matrix &ptcmm, const ptc_matrix &ptcm);
-
 #endif /* UTILS_SIM_HPP */